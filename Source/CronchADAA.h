@@ -0,0 +1,215 @@
+/*
+  ==============================================================================
+
+    CronchADAA.h
+
+    Antiderivative anti-aliasing for CRONCH and ABSOLUTION.
+
+    Instead of evaluating the shaper at each sample, ADAA evaluates the divided
+    difference of its antiderivative between consecutive samples, which acts
+    like a one-sample box filter applied to the continuous-time output and
+    removes most of the aliasing at the host sample rate. The second-order form
+    does the same with the second antiderivative over three samples.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+enum class ShaperAntialiasing
+{
+    none,
+    firstOrderADAA,     // half a sample of delay
+    secondOrderADAA     // one sample of delay
+};
+
+//==============================================================================
+/**
+    Closed-form antiderivatives of the shaper, i.e. CRONCH, or CRONCH followed
+    by ABSOLUTION, for one set of parameters.
+
+    Both shapes have the form f(x) = s(x) * g(x), where g is even and
+    non-negative and s flips from -1 to +1 where x + dcOffset crosses zero, at
+    x = c. With G and H the first and second antiderivatives of g (taken from
+    zero), the antiderivatives of f taken from c are:
+
+        F1(x) = |G(x) - G(c)|
+        F2(x) = sgn(x - c) * (H(x) - H(c) - G(c) * (x - c))
+
+    For CRONCH g(x) = 1 - exp(-a|x|). For ABSOLUTION after CRONCH, g is the
+    gate 1[|x| > T], with T the threshold mapped back to the input.
+
+    Everything is done in double precision: the divided differences cancel
+    heavily when consecutive samples are close.
+*/
+struct CronchAntiderivative
+{
+    /** gateArgument is IntrusionKernel's absolutionArgumentThreshold(), in units of |x| * amount. */
+    CronchAntiderivative (double cronchAmount, double dcOffset, bool absolutionOn, double gateArgument) noexcept
+        : amount (juce::jlimit (0.01, 100.0, cronchAmount)),
+          centre (-dcOffset),
+          gate (absolutionOn),
+          gateThreshold (gateArgument / amount)
+    {
+        centreG = G (centre);
+        centreH = H (centre);
+    }
+
+    /** The shaper itself. */
+    inline double f (double x) const noexcept
+    {
+        return x < centre ? -g (x) : g (x);
+    }
+
+    inline double F1 (double x) const noexcept
+    {
+        return std::abs (G (x) - centreG);
+    }
+
+    inline double F2 (double x) const noexcept
+    {
+        const auto d = H (x) - centreH - centreG * (x - centre);
+        return x < centre ? -d : d;
+    }
+
+private:
+    inline double g (double x) const noexcept
+    {
+        return gate ? (std::abs (x) > gateThreshold ? 1.0 : 0.0)
+                    : -std::expm1 (-amount * std::abs (x));
+    }
+
+    inline double G (double x) const noexcept
+    {
+        if (gate)
+            return std::copysign (juce::jmax (0.0, std::abs (x) - gateThreshold), x);
+
+        // x - sgn(x) * (1 - exp(-a|x|)) / a, written with expm1 to keep small x accurate
+        return x - std::copysign (-std::expm1 (-amount * std::abs (x)), x) / amount;
+    }
+
+    inline double H (double x) const noexcept
+    {
+        const auto ax = std::abs (x);
+
+        if (gate)
+            return juce::square (juce::jmax (0.0, ax - gateThreshold)) * 0.5;
+
+        return x * x * 0.5 - ax / amount - std::expm1 (-amount * ax) / (amount * amount);
+    }
+
+    double amount, centre;
+    bool gate;
+    double gateThreshold;
+    double centreG = 0.0, centreH = 0.0;
+};
+
+//==============================================================================
+/**
+    Runs first- or second-order ADAA over one channel, carrying the input
+    history between blocks.
+
+    When consecutive inputs are closer than tolerance the divided differences
+    are ill-conditioned, so the usual fallbacks are used instead: the shaper
+    (or its first antiderivative) evaluated at the midpoint.
+*/
+class CronchADAA
+{
+public:
+    struct State
+    {
+        double x1 = 0.0, x2 = 0.0;
+    };
+
+    static constexpr double tolerance = 1.0e-5;
+
+    template <typename SampleType>
+    static void process (SampleType* data, int numSamples, State& state,
+                         const CronchAntiderivative& shaper, ShaperAntialiasing order) noexcept
+    {
+        if (order == ShaperAntialiasing::secondOrderADAA)
+            processSecondOrder (data, numSamples, state, shaper);
+        else
+            processFirstOrder (data, numSamples, state, shaper);
+    }
+
+private:
+    template <typename SampleType>
+    static void processFirstOrder (SampleType* data, int numSamples, State& state, const CronchAntiderivative& shaper) noexcept
+    {
+        // Both inputs are kept, even though only x1 is needed here, so that
+        // switching to second order carries on from the right history
+        auto x1 = state.x1, x2 = state.x2;
+        auto previousF1 = shaper.F1 (x1);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto x = (double) data[i];
+            const auto currentF1 = shaper.F1 (x);
+            const auto difference = x - x1;
+
+            data[i] = (SampleType) (std::abs (difference) > tolerance ? (currentF1 - previousF1) / difference
+                                                                 : shaper.f (0.5 * (x + x1)));
+            x2 = x1;
+            x1 = x;
+            previousF1 = currentF1;
+        }
+
+        state.x1 = x1;
+        state.x2 = x2;
+    }
+
+    /** First divided difference of F2, falling back to F1 at the midpoint. */
+    static inline double dividedDifference (const CronchAntiderivative& shaper,
+                                            double a, double b, double F2a, double F2b) noexcept
+    {
+        const auto difference = a - b;
+        return std::abs (difference) > tolerance ? (F2a - F2b) / difference
+                                                 : shaper.F1 (0.5 * (a + b));
+    }
+
+    template <typename SampleType>
+    static void processSecondOrder (SampleType* data, int numSamples, State& state, const CronchAntiderivative& shaper) noexcept
+    {
+        auto x1 = state.x1, x2 = state.x2;
+        auto previousF2 = shaper.F2 (x1);
+        auto previousD1 = dividedDifference (shaper, x1, x2, previousF2, shaper.F2 (x2));
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto x = (double) data[i];
+            const auto currentF2 = shaper.F2 (x);
+            const auto currentD1 = dividedDifference (shaper, x, x1, currentF2, previousF2);
+            const auto span = x - x2;
+
+            double y;
+
+            if (std::abs (span) > tolerance)
+            {
+                y = 2.0 * (currentD1 - previousD1) / span;
+            }
+            else
+            {
+                // x[n] ~ x[n-2]: take the limit around their midpoint
+                const auto midpoint = 0.5 * (x + x2);
+                const auto delta = midpoint - x1;
+
+                y = std::abs (delta) > tolerance ? 2.0 / delta * (shaper.F1 (midpoint) + (previousF2 - shaper.F2 (midpoint)) / delta)
+                                                 : shaper.f (0.5 * (midpoint + x1));
+            }
+
+            data[i] = (SampleType) y;
+
+            x2 = x1;
+            x1 = x;
+            previousF2 = currentF2;
+            previousD1 = currentD1;
+        }
+
+        state.x1 = x1;
+        state.x2 = x2;
+    }
+};
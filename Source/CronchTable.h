@@ -0,0 +1,122 @@
+/*
+  ==============================================================================
+
+    CronchTable.h
+
+    A compile-time generated, linearly interpolated table of the CRONCH curve.
+
+    CRONCH is copysign(1 - exp(-|x| * amount), x + dcOffset). The amount only
+    scales the argument, so a single table of 1 - exp(-u) over u covers every
+    amount and no second dimension is needed.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "FastExp.h"
+
+//==============================================================================
+/** exp(-u) for u >= 0 in double precision, usable in constant expressions. */
+constexpr double constexprExpNegative (double u) noexcept
+{
+    constexpr double ln2 = 0.693147180559945309417;
+    double scale = 1.0;
+
+    while (u >= ln2)
+    {
+        u -= ln2;
+        scale *= 0.5;
+    }
+
+    double term = 1.0, sum = 1.0;
+
+    for (int n = 1; n < 20; ++n)
+    {
+        term *= -u / (double) n;
+        sum += term;
+    }
+
+    return sum * scale;
+}
+
+/** 1 - exp(-u) at Size evenly spaced points over [0, maxArgument], plus a
+    repeat of the last point so interpolation never reads past the end.
+
+    Successive points are generated by repeated multiplication, which keeps
+    compile-time evaluation well inside the compilers' constexpr step limits.
+*/
+template <int Size>
+constexpr std::array<float, (size_t) Size + 1> makeCronchCurve (float maxArgument) noexcept
+{
+    std::array<float, (size_t) Size + 1> table {};
+
+    const auto ratio = constexprExpNegative ((double) maxArgument / (double) (Size - 1));
+    double decay = 1.0;
+
+    for (size_t i = 0; i < (size_t) Size; ++i)
+    {
+        table[i] = (float) (1.0 - decay);
+        decay *= ratio;
+    }
+
+    table[(size_t) Size] = table[(size_t) Size - 1];
+    return table;
+}
+
+//==============================================================================
+/**
+    1 - exp(-u) sampled at Size points over [0, FastExp::maxArgument].
+
+    The table is built by the compiler, so there is no start-up cost and no
+    allocation. Linear interpolation of a curve whose second derivative is
+    bounded by 1 is off by at most step^2 / 8, which is what errorBound reports
+    (plus the rounding of the stored floats).
+*/
+template <int Size>
+struct CronchTable
+{
+    static_assert (Size >= 16, "Table too small to be useful");
+
+    static constexpr float maxArgument = FastExp::maxArgument;
+    static constexpr double step = (double) maxArgument / (double) (Size - 1);
+    static constexpr double errorBound = step * step / 8.0 + 6.0e-8;
+
+    /** Smallest table whose interpolation error stays under the given bound. */
+    static constexpr int sizeForError (double maxError) noexcept
+    {
+        int size = 16;
+
+        while ((double) maxArgument / (double) (size - 1) * (double) maxArgument / (double) (size - 1) / 8.0 + 6.0e-8 > maxError)
+            size *= 2;
+
+        return size;
+    }
+
+    /** Shaper magnitude for a non-negative argument. */
+    static inline float lookup (float u) noexcept
+    {
+        const auto position = juce::jmin (u, maxArgument) * (float) (1.0 / step);
+        const auto index = (int) position;
+        const auto fraction = position - (float) index;
+
+        // values has one spare entry past the end, so index + 1 is always valid
+        return values[(size_t) index] + fraction * (values[(size_t) index + 1] - values[(size_t) index]);
+    }
+
+    /** Table-driven equivalent of applyCronchToSample, for non-realtime use
+        such as drawing the curve in the editor.
+    */
+    static inline float shape (float x, float amount, float dcOffset) noexcept
+    {
+        amount = juce::jlimit (0.01f, 100.0f, amount);
+        return std::copysign (lookup (std::abs (x) * amount), x + dcOffset);
+    }
+
+private:
+    static constexpr std::array<float, (size_t) Size + 1> values = makeCronchCurve<Size> (maxArgument);
+};
+
+/** 4096 points, worst-case error about 2.3e-6: a little better than the fast exp tier. */
+using DefaultCronchTable = CronchTable<CronchTable<16>::sizeForError (4.0e-6)>;
@@ -0,0 +1,181 @@
+/*
+  ==============================================================================
+
+    DSPLoadMeter.h
+
+    Times every processBlock against its real-time budget (the block's length
+    in seconds) and keeps an average, a peak, the worst case and a histogram
+    of the load, so each instance can show how close it is to its deadline.
+    The host's meter only shows the total.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Load is the block's processing time as a fraction of its duration, so 1.0
+    means the block took exactly as long as it plays for.
+
+    The audio thread is the only writer. Every value it publishes is an atomic
+    stored once per block, so readers on any thread never wait and never block
+    the audio thread, but the fields of one getStatistics() call may come from
+    neighbouring blocks. Resets are requested by readers and carried out by the
+    audio thread at its next block, which keeps it the only writer.
+*/
+class DSPLoadMeter
+{
+public:
+    // 2% wide bins from 0 to 200%; the last bin also takes everything above that
+    static constexpr int numHistogramBins = 100;
+    static constexpr float histogramRange = 2.0f;
+
+    struct Statistics
+    {
+        float average = 0.0f;   // over roughly the last second
+        float peak = 0.0f;      // recent maximum, falling back over a couple of seconds
+        float worst = 0.0f;     // maximum since the last reset
+        float p50 = 0.0f, p95 = 0.0f, p99 = 0.0f, p999 = 0.0f;    // from the histogram, rounded up to its bins
+        juce::uint64 numBlocks = 0;
+        juce::uint64 numOverruns = 0;                                   // blocks with a load above 1
+    };
+
+    //==============================================================================
+    /** Call from prepareToPlay, before processing starts. */
+    void prepare (double sampleRate) noexcept
+    {
+        secondsPerSample = 1.0 / sampleRate;
+        budgetTicksPerSample = (double) juce::Time::getHighResolutionTicksPerSecond() * secondsPerSample;
+        resetNow();
+    }
+
+    /** Asks the audio thread to clear everything at its next block. Safe from any thread. */
+    void reset() noexcept       { resetRequested = true; }
+
+    /** Times the enclosing scope as one block of numSamples. */
+    class ScopedTimer
+    {
+    public:
+        ScopedTimer (DSPLoadMeter& meterToUse, int numSamplesInBlock) noexcept
+            : meter (meterToUse), numSamples (numSamplesInBlock), start (juce::Time::getHighResolutionTicks()) {}
+
+        ~ScopedTimer() noexcept     { meter.addBlock (juce::Time::getHighResolutionTicks() - start, numSamples); }
+
+        ScopedTimer (const ScopedTimer&) = delete;
+        ScopedTimer& operator= (const ScopedTimer&) = delete;
+
+    private:
+        DSPLoadMeter& meter;
+        const int numSamples;
+        const juce::int64 start;
+    };
+
+    /** Records one block. Only called from the audio thread. */
+    void addBlock (juce::int64 elapsedTicks, int numSamples) noexcept
+    {
+        if (resetRequested.exchange (false))
+            resetNow();
+
+        if (numSamples <= 0 || budgetTicksPerSample <= 0.0)
+            return;
+
+        const auto load = (float) ((double) elapsedTicks / (budgetTicksPerSample * numSamples));
+        const auto blockSeconds = secondsPerSample * numSamples;
+
+        // Both time constants are in seconds, so the meters behave the same at any block size
+        currentAverage += (float) (1.0 - std::exp (-blockSeconds / averageSeconds)) * (load - currentAverage);
+        currentPeak = juce::jmax (load, currentPeak * (float) std::exp (-blockSeconds / peakFallSeconds));
+        currentWorst = juce::jmax (load, currentWorst);
+
+        average.store (currentAverage, std::memory_order_relaxed);
+        peak.store (currentPeak, std::memory_order_relaxed);
+        worst.store (currentWorst, std::memory_order_relaxed);
+
+        auto& bin = histogram[(size_t) juce::jlimit (0, numHistogramBins - 1, (int) (load * (numHistogramBins / histogramRange)))];
+        bin.store (bin.load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+        if (load > 1.0f)
+            numOverruns.store (numOverruns.load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+        numBlocks.store (numBlocks.load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    //==============================================================================
+    Statistics getStatistics() const noexcept
+    {
+        Statistics s;
+        s.average = average.load (std::memory_order_relaxed);
+        s.peak = peak.load (std::memory_order_relaxed);
+        s.worst = worst.load (std::memory_order_relaxed);
+        s.numBlocks = numBlocks.load (std::memory_order_relaxed);
+        s.numOverruns = numOverruns.load (std::memory_order_relaxed);
+
+        std::array<juce::uint64, (size_t) numHistogramBins> counts;
+        juce::uint64 total = 0;
+
+        for (size_t i = 0; i < counts.size(); ++i)
+            total += (counts[i] = histogram[i].load (std::memory_order_relaxed));
+
+        s.p50 = getPercentile (counts, total, 0.5);
+        s.p95 = getPercentile (counts, total, 0.95);
+        s.p99 = getPercentile (counts, total, 0.99);
+        s.p999 = getPercentile (counts, total, 0.999);
+        return s;
+    }
+
+    /** The number of blocks per histogram bin, bin i covering loads from
+        i * histogramRange / numHistogramBins upwards.
+    */
+    juce::uint64 getHistogramCount (int bin) const noexcept
+    {
+        return histogram[(size_t) juce::jlimit (0, numHistogramBins - 1, bin)].load (std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr double averageSeconds = 1.0;
+    static constexpr double peakFallSeconds = 2.0;
+
+    double secondsPerSample = 0.0, budgetTicksPerSample = 0.0;
+
+    // The audio thread's own copies, published through the atomics below
+    float currentAverage = 0.0f, currentPeak = 0.0f, currentWorst = 0.0f;
+
+    std::atomic<float> average { 0.0f }, peak { 0.0f }, worst { 0.0f };
+    std::atomic<juce::uint64> numBlocks { 0 }, numOverruns { 0 };
+    std::array<std::atomic<juce::uint32>, (size_t) numHistogramBins> histogram {};
+    std::atomic<bool> resetRequested { false };
+
+    void resetNow() noexcept
+    {
+        currentAverage = currentPeak = currentWorst = 0.0f;
+        average = peak = worst = 0.0f;
+        numBlocks = numOverruns = 0;
+
+        for (auto& bin : histogram)
+            bin = 0;
+    }
+
+    // The upper edge of the bin holding the given fraction of blocks
+    static float getPercentile (const std::array<juce::uint64, (size_t) numHistogramBins>& counts,
+                                juce::uint64 total, double fraction) noexcept
+    {
+        if (total == 0)
+            return 0.0f;
+
+        const auto target = (juce::uint64) std::ceil (fraction * (double) total);
+        juce::uint64 cumulative = 0;
+
+        for (size_t i = 0; i < counts.size(); ++i)
+        {
+            cumulative += counts[i];
+
+            if (cumulative >= target)
+                return (float) (i + 1) * (histogramRange / numHistogramBins);
+        }
+
+        return histogramRange;
+    }
+};
@@ -0,0 +1,132 @@
+/*
+  ==============================================================================
+
+    FastExp.h
+
+    Vectorised exp(-u) approximations used by CRONCH, so that the shaper costs
+    a handful of multiply-adds per SIMD register instead of a libm call per
+    sample.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/** How closely the vectorised CRONCH should track std::expf. */
+enum class CronchAccuracy
+{
+    reference,  // within 1-2 ulp of std::expf, CRONCH output within ~6e-8
+    fast,       // ~3.5e-6 worst-case error on the CRONCH output, about half the work
+    table       // interpolated DefaultCronchTable, ~2.3e-6 error, two loads and a lerp per sample
+};
+
+//==============================================================================
+/**
+    exp(-u) for u >= 0, written only in terms of the arithmetic, comparison and
+    mask operations juce::dsp::SIMDRegister provides, so the same code runs on
+    any lane width.
+
+    SIMDRegister has no portable float/int reinterpretation, so instead of the
+    usual exponent bit trick the range reduction is done with compares: the
+    reference tier peels off multiples of ln2 one power of two at a time, and
+    the fast tier divides the argument by 16 and squares the result back up.
+*/
+struct FastExp
+{
+    /** Beyond this, 1 - exp(-u) rounds to exactly 1.0f, so arguments are clamped here. */
+    static constexpr float maxArgument = 17.5f;
+
+    /** The same limit for double, where exp(-u) drops below 2^-54 at about 37.4. */
+    template <typename Type>
+    static constexpr Type maxArgumentFor() noexcept
+    {
+        return sizeof (Type) > sizeof (float) ? (Type) 37.5 : (Type) maxArgument;
+    }
+
+    template <typename Vec>
+    static inline Vec expNegative (Vec u, CronchAccuracy accuracy) noexcept
+    {
+        return accuracy == CronchAccuracy::fast ? expNegativeFast (u) : expNegativeReference (u);
+    }
+
+    /** Cody-Waite style reduction to r in [0, ln2 / 2), then a degree 7 Taylor
+        series, or degree 12 in double precision.
+    */
+    template <typename Vec>
+    static inline Vec expNegativeReference (Vec u) noexcept
+    {
+        using Type = typename Vec::ElementType;
+        constexpr bool isDouble = sizeof (Type) > sizeof (float);
+
+        constexpr Type ln2Hi = (Type) 0.693145751953125;
+        constexpr Type ln2Lo = (Type) 1.42860682030941723212e-6;
+
+        // multiples of ln2 to peel off, and 2^-step - 1 so that a mask picks either it or zero.
+        // Float never needs the first step, as maxArgument is below 32 ln2.
+        constexpr Type steps[]  = { 32, 16, 8, 4, 2, 1, (Type) 0.5 };
+        constexpr Type scales[] = { (Type) (1.0 / 4294967296.0) - 1, (Type) (1.0 / 65536.0) - 1, (Type) (1.0 / 256.0) - 1,
+                                    (Type) (1.0 / 16.0) - 1, (Type) 0.25 - 1, (Type) 0.5 - 1, (Type) 0.70710678118654752440 - 1 };
+
+        const auto one = Vec::expand ((Type) 1);
+        auto scale = one;
+
+        for (int i = isDouble ? 0 : 1; i < 7; ++i)
+        {
+            const auto take = Vec::greaterThanOrEqual (u, Vec::expand (steps[i] * (ln2Hi + ln2Lo)));
+            u = u - (Vec::expand (steps[i] * ln2Hi) & take) - (Vec::expand (steps[i] * ln2Lo) & take);
+            scale = scale * (one + (Vec::expand (scales[i]) & take));
+        }
+
+        auto p = Vec::expand ((Type) (-1.0 / 5040.0));
+
+        if constexpr (isDouble)
+        {
+            p = u * (Type) (1.0 / 479001600.0) + (Type) (-1.0 / 39916800.0);
+            p = p * u + (Type) (1.0 / 3628800.0);
+            p = p * u + (Type) (-1.0 / 362880.0);
+            p = p * u + (Type) (1.0 / 40320.0);
+            p = p * u + (Type) (-1.0 / 5040.0);
+        }
+
+        p = p * u + (Type) (1.0 / 720.0);
+        p = p * u + (Type) (-1.0 / 120.0);
+        p = p * u + (Type) (1.0 / 24.0);
+        p = p * u + (Type) (-1.0 / 6.0);
+        p = p * u + (Type) 0.5;
+        p = p * u + (Type) -1;
+        p = p * u + (Type) 1;
+
+        return p * scale;
+    }
+
+    /** exp(-u / 16) from a degree 4 Taylor series, squared four times. */
+    template <typename Vec>
+    static inline Vec expNegativeFast (Vec u) noexcept
+    {
+        using Type = typename Vec::ElementType;
+
+        const auto r = u * (Type) (1.0 / 16.0);
+
+        auto p = r * (Type) (1.0 / 24.0) + (Type) (-1.0 / 6.0);
+        p = p * r + (Type) 0.5;
+        p = p * r + (Type) -1;
+        p = p * r + (Type) 1;
+
+        p = p * p;
+        p = p * p;
+        p = p * p;
+        return p * p;
+    }
+};
+
+//==============================================================================
+/** Worst-case deviation of the vectorised CRONCH from applyCronchToSample. */
+struct CronchAccuracyReport
+{
+    float maxAbsoluteError = 0.0f;
+    float worstInput = 0.0f;
+    float worstAmount = 0.0f;
+};
@@ -0,0 +1,292 @@
+/*
+  ==============================================================================
+
+    IntrusionEngine.cpp
+
+  ==============================================================================
+*/
+
+#include "IntrusionEngine.h"
+
+//==============================================================================
+bool IntrusionEngine::ParameterSnapshot::setRawValue (const juce::String& parameterID, float value)
+{
+    // Values come from preset files and the command line as well as from the
+    // plugin's parameters, so each is held to its parameter's range; NaN takes
+    // the bottom of the range
+    const auto limit = [value] (float low, float high) { return value >= low ? juce::jmin (value, high) : low; };
+    const auto choice = [&limit] (int numChoices)     { return juce::roundToInt (limit (0.0f, (float) (numChoices - 1))); };
+
+    if      (parameterID == "cronchAmount")         cronchAmount = limit (0.0f, 100.0f);
+    else if (parameterID == "absoluteOffset")       dcOffset = limit (-1.0f, 1.0f);
+    else if (parameterID == "dryLevel")             dryLevel = limit (0.0f, 1.0f);
+    else if (parameterID == "octaveLevel")          octaveLevel = limit (0.0f, 1.0f);
+    else if (parameterID == "octave2Level")         octave2Level = limit (0.0f, 1.0f);
+    else if (parameterID == "octave3Level")         octave3Level = limit (0.0f, 1.0f);
+    else if (parameterID == "ochoLPFCutoff")        ochoLPFCutoff = limit (50.0f, 8000.0f);
+    else if (parameterID == "ochoSlope")            ochoSlope = choice (4);
+    else if (parameterID == "ochoHPFOn")            ochoHPFOn = value > 0.5f;
+    else if (parameterID == "ochoHPFCutoff")        ochoHPFCutoff = limit (20.0f, 2000.0f);
+    else if (parameterID == "absolutionOn")         absolutionOn = value > 0.5f;
+    else if (parameterID == "absolutionThreshold")  absolutionThreshold = limit (0.0f, 1.0f);
+    else if (parameterID == "cronchQuality")        cronchAccuracy = (CronchAccuracy) choice (3);
+    else if (parameterID == "oversampling")         oversampling = choice (4);
+    else if (parameterID == "antialiasing")         antialiasing = (ShaperAntialiasing) choice (3);
+    else                                            return false;
+
+    return true;
+}
+
+float IntrusionEngine::ParameterSnapshot::getRawValue (const juce::String& parameterID) const
+{
+    if (parameterID == "cronchAmount")         return cronchAmount;
+    if (parameterID == "absoluteOffset")       return dcOffset;
+    if (parameterID == "dryLevel")             return dryLevel;
+    if (parameterID == "octaveLevel")          return octaveLevel;
+    if (parameterID == "octave2Level")         return octave2Level;
+    if (parameterID == "octave3Level")         return octave3Level;
+    if (parameterID == "ochoLPFCutoff")        return ochoLPFCutoff;
+    if (parameterID == "ochoSlope")            return (float) ochoSlope;
+    if (parameterID == "ochoHPFOn")            return ochoHPFOn ? 1.0f : 0.0f;
+    if (parameterID == "ochoHPFCutoff")        return ochoHPFCutoff;
+    if (parameterID == "absolutionOn")         return absolutionOn ? 1.0f : 0.0f;
+    if (parameterID == "absolutionThreshold")  return absolutionThreshold;
+    if (parameterID == "cronchQuality")        return (float) cronchAccuracy;
+    if (parameterID == "oversampling")         return (float) oversampling;
+    if (parameterID == "antialiasing")         return (float) antialiasing;
+
+    return 0.0f;
+}
+
+double IntrusionEngine::getTailLengthSeconds (const ParameterSnapshot& snapshot) noexcept
+{
+    // The Ocho filter is the only part of the chain that rings. A section with
+    // cutoff fc decays as exp(-2 pi fc t / 2Q), so the slowest pole is the
+    // highest-Q section of the low-pass, or the high-pass.
+    using Cascade = OchoCascade<double>;
+    const auto numSections = juce::jlimit (1, Cascade::maxLowPassSections, snapshot.ochoSlope + 1);
+    auto decay = juce::MathConstants<double>::twoPi * snapshot.ochoLPFCutoff
+                   * Cascade::butterworthInverseQ (numSections - 1, numSections) * 0.5;
+
+    if (snapshot.ochoHPFOn)
+        decay = juce::jmin (decay, juce::MathConstants<double>::twoPi * snapshot.ochoHPFCutoff / juce::MathConstants<double>::sqrt2);
+
+    return std::log (1.0 / silenceThreshold) / decay;
+}
+
+//==============================================================================
+void IntrusionEngine::prepare (double sampleRate, int maximumBlockSize, int numChannels,
+                               bool useDoublePrecision, const ParameterSnapshot& snapshot)
+{
+    jassert (numChannels <= maxChannels);
+
+    resetSmoothers (sampleRate, snapshot);
+
+    // Only one chain needs setting up, as the precision is fixed until the next prepare
+    activeOversampling = -1;
+
+    if (useDoublePrecision)
+        prepareChain (doubleChain, sampleRate, maximumBlockSize, numChannels, snapshot);
+    else
+        prepareChain (floatChain, sampleRate, maximumBlockSize, numChannels, snapshot);
+
+    idle = false;
+    quietSamples = 0;
+}
+
+template <typename SampleType>
+void IntrusionEngine::prepareChain (ProcessingChain<SampleType>& chain, double sampleRate, int maximumBlockSize,
+                                    int numChannels, const ParameterSnapshot& snapshot)
+{
+    chain.kernel.prepare (numChannels);
+    chain.ochoCoefficients.prepare (sampleRate, snapshot.getOchoResponse());
+
+    for (size_t i = 0; i < chain.oversamplers.size(); ++i)
+    {
+        chain.oversamplers[i] = std::make_unique<juce::dsp::Oversampling<SampleType>> ((size_t) numChannels, i + 1,
+                                                                                       juce::dsp::Oversampling<SampleType>::filterHalfBandPolyphaseIIR,
+                                                                                       true, true);
+        chain.oversamplers[i]->initProcessing ((size_t) maximumBlockSize);
+    }
+
+    setActiveOversampling (chain, snapshot.oversampling);
+}
+
+void IntrusionEngine::resetSmoothers (double sampleRate, const ParameterSnapshot& snapshot)
+{
+    // Same 20 ms as the Ocho coefficient ramp
+    constexpr double rampLengthSeconds = 0.02;
+
+    cronchAmountSmoother.reset (sampleRate, rampLengthSeconds);
+    dcOffsetSmoother.reset (sampleRate, rampLengthSeconds);
+    dryLevelSmoother.reset (sampleRate, rampLengthSeconds);
+    octaveLevelSmoother.reset (sampleRate, rampLengthSeconds);
+    octave2LevelSmoother.reset (sampleRate, rampLengthSeconds);
+    octave3LevelSmoother.reset (sampleRate, rampLengthSeconds);
+    absolutionThresholdSmoother.reset (sampleRate, rampLengthSeconds);
+
+    // The multiplicative ramp can't start from or head for zero, so the clamp
+    // the shaper would apply anyway happens here instead
+    cronchAmountSmoother.setCurrentAndTargetValue (juce::jlimit (0.01f, 100.0f, snapshot.cronchAmount));
+    dcOffsetSmoother.setCurrentAndTargetValue (snapshot.dcOffset);
+    dryLevelSmoother.setCurrentAndTargetValue (snapshot.dryLevel);
+    octaveLevelSmoother.setCurrentAndTargetValue (snapshot.octaveLevel);
+    octave2LevelSmoother.setCurrentAndTargetValue (snapshot.octave2Level);
+    octave3LevelSmoother.setCurrentAndTargetValue (snapshot.octave3Level);
+    absolutionThresholdSmoother.setCurrentAndTargetValue (snapshot.absolutionThreshold);
+}
+
+// Moves a smoother on by one block and returns the line the kernel should
+// follow across it, after mapping both ends through map
+template <typename SampleType, typename Smoother, typename Mapping>
+static typename IntrusionKernel<SampleType>::LinearRamp takeBlockRamp (Smoother& smoother, int numSamples, Mapping&& map)
+{
+    const auto start = map ((SampleType) smoother.getCurrentValue());
+
+    if (! smoother.isSmoothing())
+        return { start, 0 };
+
+    smoother.skip (numSamples);
+    return IntrusionKernel<SampleType>::LinearRamp::between (start, map ((SampleType) smoother.getCurrentValue()), numSamples);
+}
+
+template <typename SampleType, typename Smoother>
+static typename IntrusionKernel<SampleType>::LinearRamp takeBlockRamp (Smoother& smoother, int numSamples)
+{
+    return takeBlockRamp<SampleType> (smoother, numSamples, [] (SampleType value) { return value; });
+}
+
+template <typename SampleType>
+void IntrusionEngine::setActiveOversampling (ProcessingChain<SampleType>& chain, int newOversampling)
+{
+    if (newOversampling == activeOversampling)
+        return;
+
+    activeOversampling = newOversampling;
+
+    if (activeOversampling > 0)
+    {
+        auto& oversampler = *chain.oversamplers[(size_t) activeOversampling - 1];
+        oversampler.reset();
+        latencySamples = juce::roundToInt (oversampler.getLatencyInSamples());
+    }
+    else
+    {
+        latencySamples = 0;
+    }
+}
+
+//==============================================================================
+void IntrusionEngine::process (juce::AudioBuffer<float>& buffer, int numChannels, const ParameterSnapshot& snapshot) noexcept
+{
+    processSamples (buffer, numChannels, floatChain, snapshot);
+}
+
+void IntrusionEngine::process (juce::AudioBuffer<double>& buffer, int numChannels, const ParameterSnapshot& snapshot) noexcept
+{
+    processSamples (buffer, numChannels, doubleChain, snapshot);
+}
+
+template <typename SampleType>
+void IntrusionEngine::processSamples (juce::AudioBuffer<SampleType>& buffer, int numChannels,
+                                      ProcessingChain<SampleType>& chain, const ParameterSnapshot& snapshot) noexcept
+{
+    using Kernel = IntrusionKernel<SampleType>;
+
+    juce::ScopedNoDenormals noDenormals;
+    const auto numSamples = buffer.getNumSamples();
+
+    // Some hosts send empty blocks, e.g. to flush parameter changes
+    if (numSamples == 0)
+        return;
+
+    cronchAmountSmoother.setTargetValue (juce::jlimit (0.01f, 100.0f, snapshot.cronchAmount));
+    dcOffsetSmoother.setTargetValue (snapshot.dcOffset);
+    dryLevelSmoother.setTargetValue (snapshot.dryLevel);
+    octaveLevelSmoother.setTargetValue (snapshot.octaveLevel);
+    octave2LevelSmoother.setTargetValue (snapshot.octave2Level);
+    octave3LevelSmoother.setTargetValue (snapshot.octave3Level);
+    absolutionThresholdSmoother.setTargetValue (snapshot.absolutionThreshold);
+
+    auto& kernel = chain.kernel;
+    auto& ochoCoefficients = chain.ochoCoefficients;
+
+    typename Kernel::Parameters kernelParams;
+    kernelParams.cronchAmount = takeBlockRamp<SampleType> (cronchAmountSmoother, numSamples);
+    kernelParams.dcOffset = takeBlockRamp<SampleType> (dcOffsetSmoother, numSamples);
+    kernelParams.dryLevel = takeBlockRamp<SampleType> (dryLevelSmoother, numSamples);
+    kernelParams.octaveLevel = takeBlockRamp<SampleType> (octaveLevelSmoother, numSamples);
+    kernelParams.octave2Level = takeBlockRamp<SampleType> (octave2LevelSmoother, numSamples);
+    kernelParams.octave3Level = takeBlockRamp<SampleType> (octave3LevelSmoother, numSamples);
+    kernelParams.absolutionOn = snapshot.absolutionOn;
+    // The gate compares in the curve's argument domain; mapping just the ends of
+    // each block keeps the log out of the per-sample loop
+    kernelParams.absolutionGate = takeBlockRamp<SampleType> (absolutionThresholdSmoother, numSamples, Kernel::absolutionArgumentThreshold);
+    kernelParams.cronchAccuracy = snapshot.cronchAccuracy;
+    kernelParams.antialiasing = snapshot.antialiasing;
+
+    // Coefficients are only recomputed when the response changes, then ramped per sample
+    ochoCoefficients.setResponse (snapshot.getOchoResponse());
+
+    setActiveOversampling (chain, snapshot.oversampling);
+
+    // Digital silence in and nothing left ringing: skip the chain, but keep the
+    // smoothers and the coefficient ramp moving so nothing jumps on the way out
+    const auto inputSilent = buffer.getMagnitude (0, numSamples) <= silenceThreshold;
+
+    if (inputSilent && idle)
+    {
+        buffer.clear();
+        ochoCoefficients.advance (numSamples);
+        return;
+    }
+
+    idle = false;
+
+    if (activeOversampling == 0 && snapshot.antialiasing == ShaperAntialiasing::none)
+    {
+        // Every channel goes through Ocho, then the mix, CRONCH and (optionally) ABSOLUTION
+        kernel.process (buffer.getArrayOfWritePointers(), numChannels, numSamples, ochoCoefficients, kernelParams);
+    }
+    else if (activeOversampling == 0)
+    {
+        // ADAA carries sample history through the shaper, so it runs as its own pass
+        kernel.processOchoAndMix (buffer.getArrayOfWritePointers(), numChannels, numSamples, ochoCoefficients, kernelParams);
+
+        auto block = juce::dsp::AudioBlock<SampleType> (buffer).getSubsetChannelBlock (0, (size_t) numChannels);
+        kernel.processShaper (block, kernelParams);
+    }
+    else
+    {
+        // Ocho and the mix run at the host rate; only the nonlinear shaper is oversampled
+        kernel.processOchoAndMix (buffer.getArrayOfWritePointers(), numChannels, numSamples, ochoCoefficients, kernelParams);
+
+        auto block = juce::dsp::AudioBlock<SampleType> (buffer).getSubsetChannelBlock (0, (size_t) numChannels);
+        auto& oversampler = *chain.oversamplers[(size_t) activeOversampling - 1];
+
+        auto upsampled = oversampler.processSamplesUp (block);
+        kernel.processShaper (upsampled, kernelParams.atOversampledRate ((int) oversampler.getOversamplingFactor()));
+        oversampler.processSamplesDown (block);
+    }
+
+    ochoCoefficients.advance (numSamples);
+
+    // The output check covers whatever the oversampling filters and ADAA still
+    // hold, and it has to stay quiet for longer than the latency to be sure
+    // nothing is still on its way through
+    if (inputSilent && kernel.isSettled ((SampleType) silenceThreshold)
+         && buffer.getMagnitude (0, numSamples) <= silenceThreshold)
+        quietSamples += numSamples;
+    else
+        quietSamples = 0;
+
+    if (quietSamples > latencySamples)
+    {
+        idle = true;
+        quietSamples = 0;
+        kernel.reset();
+
+        if (activeOversampling > 0)
+            chain.oversamplers[(size_t) activeOversampling - 1]->reset();
+    }
+}
@@ -0,0 +1,133 @@
+/*
+  ==============================================================================
+
+    IntrusionEngine.h
+
+    Everything INTRUSION does to audio, without the plugin around it: the
+    kernel, the Ocho coefficient ramp, oversampling, parameter smoothing and
+    the idle bypass. The plugin drives it from processBlock; headless tools
+    such as the batch renderer drive it straight from a file.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "IntrusionKernel.h"
+
+//==============================================================================
+class IntrusionEngine
+{
+public:
+    //==============================================================================
+    /** Every parameter, as raw (denormalised) values. The defaults match the
+        plugin's parameter defaults.
+    */
+    struct ParameterSnapshot
+    {
+        float cronchAmount = 1.0f;
+        float dcOffset = 0.0f;
+        float dryLevel = 1.0f;
+        float octaveLevel = 1.0f;
+        float octave2Level = 0.0f;
+        float octave3Level = 0.0f;
+        float ochoLPFCutoff = 1000.0f;
+        int ochoSlope = 0;          // 0 to 3 for 12 to 48 dB/oct
+        bool ochoHPFOn = false;
+        float ochoHPFCutoff = 80.0f;
+        bool absolutionOn = false;
+        float absolutionThreshold = 0.5f;
+        CronchAccuracy cronchAccuracy = CronchAccuracy::reference;
+        int oversampling = 0;
+        ShaperAntialiasing antialiasing = ShaperAntialiasing::none;
+
+        OchoResponse getOchoResponse() const noexcept
+        {
+            return { ochoLPFCutoff, ochoSlope + 1, ochoHPFOn, ochoHPFCutoff };
+        }
+
+        /** Sets one field from its parameter ID and raw value, the way the
+            plugin stores them, clamped to the parameter's range. Returns false
+            for an unknown ID.
+        */
+        bool setRawValue (const juce::String& parameterID, float value);
+
+        /** The raw value of one field by parameter ID, or 0 for an unknown ID. */
+        float getRawValue (const juce::String& parameterID) const;
+    };
+
+    // Enough for 7th order ambisonics; the kernel itself has no limit
+    static constexpr int maxChannels = 64;
+
+    // Below this the input counts as silence, and the Ocho state as rung out
+    static constexpr float silenceThreshold = 1.0e-9f;
+
+    //==============================================================================
+    /** Allocates everything for the given precision. Only that precision's
+        process() may be called until the next prepare().
+    */
+    void prepare (double sampleRate, int maximumBlockSize, int numChannels,
+                  bool useDoublePrecision, const ParameterSnapshot& snapshot);
+
+    /** Processes the first numChannels channels of buffer in place. Never
+        allocates, and the block may be any length up to the prepared maximum.
+    */
+    void process (juce::AudioBuffer<float>& buffer, int numChannels, const ParameterSnapshot& snapshot) noexcept;
+    void process (juce::AudioBuffer<double>& buffer, int numChannels, const ParameterSnapshot& snapshot) noexcept;
+
+    /** The delay of the oversampling filters currently in use. process() updates
+        it when the oversampling choice changes; it can be read from any thread,
+        so the change can be reported to the host from somewhere other than the
+        audio thread.
+    */
+    int getLatencySamples() const noexcept     { return latencySamples; }
+
+    /** How long the chain keeps ringing after the input stops, not counting
+        latency, for the filter settings in snapshot.
+    */
+    static double getTailLengthSeconds (const ParameterSnapshot& snapshot) noexcept;
+
+private:
+    //==============================================================================
+    // Everything that runs at the processing precision. Only the chain
+    // matching the prepared precision is allocated.
+    template <typename SampleType>
+    struct ProcessingChain
+    {
+        IntrusionKernel<SampleType> kernel; // Ocho filter, flip-flop and shaper state, packed into SIMD lanes
+        OchoCoefficientEngine<SampleType> ochoCoefficients;
+
+        // 2x, 4x and 8x oversampling around CRONCH and ABSOLUTION, all prepared up front
+        // so that switching factor never allocates on the audio thread
+        std::array<std::unique_ptr<juce::dsp::Oversampling<SampleType>>, 3> oversamplers;
+    };
+
+    ProcessingChain<float> floatChain;
+    ProcessingChain<double> doubleChain;
+    int activeOversampling = 0; // 0 = off, otherwise index + 1 into oversamplers
+    std::atomic<int> latencySamples { 0 };
+
+    template <typename SampleType>
+    void prepareChain (ProcessingChain<SampleType>& chain, double sampleRate, int maximumBlockSize,
+                       int numChannels, const ParameterSnapshot& snapshot);
+
+    template <typename SampleType>
+    void setActiveOversampling (ProcessingChain<SampleType>& chain, int newOversampling);
+
+    template <typename SampleType>
+    void processSamples (juce::AudioBuffer<SampleType>& buffer, int numChannels,
+                         ProcessingChain<SampleType>& chain, const ParameterSnapshot& snapshot) noexcept;
+
+    // Advanced once per block; the kernel replays each block's ramp per sample
+    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative> cronchAmountSmoother;
+    juce::SmoothedValue<float> dcOffsetSmoother, dryLevelSmoother, absolutionThresholdSmoother;
+    juce::SmoothedValue<float> octaveLevelSmoother, octave2LevelSmoother, octave3LevelSmoother;
+
+    void resetSmoothers (double sampleRate, const ParameterSnapshot& snapshot);
+
+    // Once the input is silent and the tail has died away for longer than the
+    // latency, the chain is skipped until the input comes back
+    bool idle = false;
+    int quietSamples = 0;
+};
@@ -0,0 +1,759 @@
+/*
+  ==============================================================================
+
+    IntrusionKernel.h
+
+    The per-sample INTRUSION chain (Ocho pre-filter, flip-flop dividers,
+    dry/octave mix, CRONCH and ABSOLUTION), processed for several channels at
+    once by packing them into the lanes of a juce::dsp::SIMDRegister.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "OchoFilter.h"
+#include "OchoFlipFlop.h"
+#include "FastExp.h"
+#include "CronchTable.h"
+#include "CronchADAA.h"
+
+//==============================================================================
+// Scalar reference versions of each stage. The SIMD kernel below must produce
+// the same results as running these one channel at a time.
+
+template <typename SampleType>
+inline SampleType applyCronchToSample(SampleType x, SampleType amount, SampleType dcOffset)
+{
+    amount = juce::jlimit((SampleType) 0.01, (SampleType) 100, amount);
+    SampleType shaped = std::copysign((SampleType) 1 - std::exp(-std::abs(x) * amount), x + dcOffset);
+    return juce::jlimit((SampleType) -1, (SampleType) 1, shaped);
+}
+
+template <typename SampleType>
+inline SampleType applyAbsolutionToSample(SampleType x, SampleType threshold)
+{
+    return std::abs(x) <= threshold ? (SampleType) 0 : (x > 0 ? (SampleType) 1 : (SampleType) -1);
+}
+
+template <typename SampleType>
+inline SampleType processOcho(SampleType input, SampleType& lastInput, SampleType& flipMultiplier, SampleType dcOffset = 0)
+{
+    // SampleType adjustedInput = input + dcOffset;
+    SampleType adjustedInput = input; // trying out only applying DC to ABSOLUTE, not octave
+    juce::ignoreUnused(dcOffset);
+
+    // Flip only on positive-going zero crossings
+    if (lastInput < 0 && adjustedInput >= 0)
+        flipMultiplier = -flipMultiplier;
+
+    lastInput = adjustedInput;
+
+    return flipMultiplier;
+}
+
+//==============================================================================
+/**
+    Runs the whole INTRUSION chain for up to Vec::size() channels per pass.
+
+    Channels are grouped into SIMD-width lanes; each group keeps its filter
+    state as vectors so the filter's serial per-sample dependency is carried
+    for all of its channels at once. The flip-flop only depends on the past at
+    zero crossings, so it runs along time instead, one channel at a time, over
+    short chunks of filtered signal. A stereo bus is a single group, so both
+    channels are processed in one pass over the block; a 12 channel 7.1.4 bus
+    is three groups of four on SSE or NEON.
+
+    SampleType is float or double, matching the host's processing precision.
+    Double halves the lanes per register but keeps the low-cutoff filter and
+    the shaper accurate to double precision.
+*/
+template <typename SampleType>
+class IntrusionKernel
+{
+public:
+    using Vec     = juce::dsp::SIMDRegister<SampleType>;
+    using MaskVec = typename Vec::vMaskType;
+    using Cascade = OchoCascade<SampleType>;
+
+    static constexpr int lanes = (int) Vec::SIMDNumElements;
+
+    /** One block of a smoothed parameter: the value at the first sample and the
+        step per sample. The processor's smoothers are advanced once per block and
+        the kernel replays the line in between, so every channel sees the same
+        values sample by sample.
+    */
+    struct LinearRamp
+    {
+        SampleType value = 0, increment = 0;
+
+        /** A ramp that reaches end one sample after the block. */
+        static LinearRamp between (SampleType start, SampleType end, int numSamples) noexcept
+        {
+            return { start, juce::exactlyEqual (start, end) ? (SampleType) 0 : (end - start) / (SampleType) juce::jmax (1, numSamples) };
+        }
+
+        bool isSteady() const noexcept                  { return juce::exactlyEqual (increment, (SampleType) 0); }
+        void advance (int numSamples = 1) noexcept      { value += increment * (SampleType) numSamples; }
+    };
+
+    struct Parameters
+    {
+        LinearRamp cronchAmount { 1 };      // already clamped to [0.01, 100]
+        LinearRamp dcOffset;
+        LinearRamp dryLevel { 1 };
+        LinearRamp octaveLevel { 1 };       // -1 octave
+        LinearRamp octave2Level;            // -2 octaves
+        LinearRamp octave3Level;            // -3 octaves
+        bool absolutionOn = false;
+        LinearRamp absolutionGate { absolutionArgumentThreshold ((SampleType) 0.5) };   // see absolutionArgumentThreshold()
+        CronchAccuracy cronchAccuracy = CronchAccuracy::reference;
+        ShaperAntialiasing antialiasing = ShaperAntialiasing::none;
+
+        bool isSteady() const noexcept
+        {
+            return cronchAmount.isSteady() && dcOffset.isSteady() && dryLevel.isSteady()
+                    && octaveLevel.isSteady() && octave2Level.isSteady() && octave3Level.isSteady()
+                    && absolutionGate.isSteady();
+        }
+
+        /** A path held at zero for the whole block contributes nothing and is skipped. */
+        bool isDryActive() const noexcept       { return isActive (dryLevel); }
+        bool isOctaveActive() const noexcept    { return isActive (octaveLevel) || isActive (octave2Level) || isActive (octave3Level); }
+
+        /** How many divider stages must run. Each stage feeds the next, so the
+            -1 octave runs whenever a lower one is heard.
+        */
+        int getNumOctaveStages() const noexcept
+        {
+            return isActive (octave3Level) ? 3 : (isActive (octave2Level) ? 2 : 1);
+        }
+
+        static bool isActive (const LinearRamp& level) noexcept
+        {
+            return ! (level.isSteady() && juce::exactlyEqual (level.value, (SampleType) 0));
+        }
+
+        /** The same ramps spread over factor times as many samples, for running
+            the shaper at an oversampled rate.
+        */
+        Parameters atOversampledRate (int factor) const noexcept
+        {
+            auto p = *this;
+
+            for (auto* ramp : { &p.cronchAmount, &p.dcOffset, &p.dryLevel, &p.octaveLevel, &p.octave2Level, &p.octave3Level, &p.absolutionGate })
+                ramp->increment /= (SampleType) factor;
+
+            return p;
+        }
+    };
+
+    /** ABSOLUTION applied to the output of CRONCH only asks whether
+        1 - exp(-u) > threshold, which is the same as u > -log(1 - threshold).
+        Mapping the threshold back through the curve once per block means the
+        curve itself never has to be evaluated while ABSOLUTION is on.
+
+        A threshold of 1 or more can never be passed; that maps to the largest
+        finite value rather than infinity so that it can still be ramped towards.
+    */
+    static inline SampleType absolutionArgumentThreshold (SampleType threshold) noexcept
+    {
+        if (threshold >= 1)
+            return std::numeric_limits<SampleType>::max();
+
+        // below epsilon / 4 (2^-25 for float), 1 - exp(-u) rounds to exactly zero
+        // and never passes the gate
+        constexpr auto smallestNonZeroArgument = std::numeric_limits<SampleType>::epsilon() / 4;
+        return juce::jmax (smallestNonZeroArgument, (SampleType) -std::log1p ((double) -threshold));
+    }
+
+    //==============================================================================
+    /** Sizes the lane state for the given channel count. Call from prepareToPlay. */
+    void prepare (int numChannels)
+    {
+        groups.resize ((size_t) ((numChannels + lanes - 1) / lanes));
+        adaaStates.resize ((size_t) numChannels);
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        for (auto& g : groups)
+        {
+            g.s1.fill (Vec::expand (0));
+            g.s2.fill (Vec::expand (0));
+            g.flipFlops.fill ({});
+            g.ochoIdle = false;
+        }
+
+        adaaPrimed = false;
+    }
+
+    int getNumChannels() const noexcept     { return (int) groups.size() * lanes; }
+
+    /** True once the Ocho filter and the held octave sample have decayed below
+        threshold in every channel, i.e. silent input would now give silent output.
+        A group whose octave path is switched off holds no live state.
+    */
+    bool isSettled (SampleType threshold) const noexcept
+    {
+        const auto limit = Vec::expand (threshold);
+
+        for (auto& g : groups)
+        {
+            if (g.ochoIdle)
+                continue;
+
+            auto peak = Vec::expand (0);
+
+            for (size_t k = 0; k < (size_t) Cascade::maxSections; ++k)
+                peak = Vec::max (peak, Vec::max (Vec::abs (g.s1[k]), Vec::abs (g.s2[k])));
+
+            if ((Vec::expand (1) & Vec::greaterThan (peak, limit)).sum() != 0)
+                return false;
+
+            for (auto& f : g.flipFlops)
+                for (auto& stage : f.stages)
+                    if (std::abs (stage.pending) > threshold)
+                        return false;
+        }
+
+        return true;
+    }
+
+    /** Processes numChannels channels in place. The coefficient ramp is replayed
+        for every group so all channels see identical coefficients per sample.
+    */
+    void process (SampleType* const* channels, int numChannels, int numSamples,
+                  const OchoCoefficientEngine<SampleType>& coefficients, const Parameters& params) noexcept
+    {
+        processGroups<true> (channels, numChannels, numSamples, coefficients, params);
+    }
+
+    /** Runs only the Ocho filter, flip-flop and dry/octave mix, leaving the mixed
+        signal in the channels for processShaper(), e.g. at an oversampled rate.
+    */
+    void processOchoAndMix (SampleType* const* channels, int numChannels, int numSamples,
+                            const OchoCoefficientEngine<SampleType>& coefficients, const Parameters& params) noexcept
+    {
+        processGroups<false> (channels, numChannels, numSamples, coefficients, params);
+    }
+
+    /** Applies CRONCH and ABSOLUTION in place. Without ADAA these stages are
+        memoryless, so the block is processed along time, Vec::size() samples
+        per register. With ADAA each channel carries a short input history.
+
+        The block may be oversampled, in which case the ramps in params must have
+        been spread to match, see Parameters::atOversampledRate().
+    */
+    void processShaper (juce::dsp::AudioBlock<SampleType>& block, const Parameters& params) noexcept
+    {
+        if (params.antialiasing != ShaperAntialiasing::none)
+        {
+            processShaperADAA (block, params);
+            return;
+        }
+
+        adaaPrimed = false;
+
+        dispatch<false, true> (params, [&] (auto stages)
+        {
+            processShaperBlock<decltype (stages)> (block, params);
+        });
+    }
+
+    /** Sweeps the vectorised CRONCH against applyCronchToSample over the full
+        amount range and an input range a little wider than full scale.
+        Tools/ShaperCheck holds each tier to its error bound with this.
+    */
+    static CronchAccuracyReport measureCronchAccuracy (CronchAccuracy accuracy, int numInputs = 2048, int numAmounts = 64)
+    {
+        CronchAccuracyReport report;
+        alignas (Vec::SIMDRegisterSize) SampleType inputs[lanes], shaped[lanes];
+
+        for (int a = 0; a < numAmounts; ++a)
+        {
+            // amounts are spread logarithmically, as most of the character is at the low end
+            const auto amount = (SampleType) 0.01 * std::pow ((SampleType) 1.0e4, (SampleType) a / (SampleType) (numAmounts - 1));
+
+            for (int i = 0; i < numInputs; i += lanes)
+            {
+                for (int l = 0; l < lanes; ++l)
+                    inputs[l] = juce::jmap ((SampleType) (i + l), (SampleType) 0, (SampleType) (numInputs - 1), (SampleType) -1.5, (SampleType) 1.5);
+
+                const auto x = Vec::fromRawArray (inputs);
+                const auto amountVec = Vec::expand (amount), dc = Vec::expand (0);
+
+                switch (accuracy)
+                {
+                    case CronchAccuracy::fast:   cronch<CronchAccuracy::fast>      (x, amountVec, dc).copyToRawArray (shaped); break;
+                    case CronchAccuracy::table:  cronch<CronchAccuracy::table>     (x, amountVec, dc).copyToRawArray (shaped); break;
+                    default:                     cronch<CronchAccuracy::reference> (x, amountVec, dc).copyToRawArray (shaped); break;
+                }
+
+                for (int l = 0; l < lanes; ++l)
+                {
+                    const auto error = (float) std::abs (shaped[l] - applyCronchToSample (inputs[l], amount, (SampleType) 0));
+
+                    if (error > report.maxAbsoluteError)
+                        report = { error, (float) inputs[l], (float) amount };
+                }
+            }
+        }
+
+        return report;
+    }
+
+private:
+    // samples per pass of processGroup(), a multiple of any Vec::size()
+    static constexpr int chunkSize = 64;
+    static constexpr int maxOctaveStages = OchoFlipFlop<SampleType>::maxStages;
+
+    struct LaneState
+    {
+        std::array<Vec, (size_t) Cascade::maxSections> s1, s2;  // Ocho pre-filter, one TDF-II biquad per section
+        std::array<OchoFlipFlop<SampleType>, (size_t) lanes> flipFlops;
+        bool ochoIdle = false;  // the octave path was skipped, so the state above is stale
+    };
+
+    /** The per-block choices that select a kernel instantiation. Stages that are
+        off are removed at compile time rather than tested per sample.
+    */
+    template <CronchAccuracy accuracyChoice, bool rampingChoice, bool shaperChoice,
+              bool absolutionChoice, bool octaveChoice, bool dryChoice>
+    struct Stages
+    {
+        static constexpr CronchAccuracy accuracy = accuracyChoice;
+        static constexpr bool ramping    = rampingChoice;      // some parameter moves during the block
+        static constexpr bool shaper     = shaperChoice;       // CRONCH or ABSOLUTION runs in this pass
+        static constexpr bool absolution = absolutionChoice;   // the gate replaces CRONCH
+        static constexpr bool octave     = octaveChoice;       // Ocho filter and flip-flop
+        static constexpr bool dry        = dryChoice;
+    };
+
+    /** Bit pattern of -0.0, used to flip or copy signs without branching. */
+    static inline MaskVec signMask() noexcept
+    {
+        using MaskType = typename MaskVec::ElementType;
+        return MaskVec::expand ((MaskType) ((MaskType) 1 << (sizeof (MaskType) * 8 - 1)));
+    }
+
+    /** 0, 1, 2, ... across the lanes, for spreading a ramp along time. */
+    static inline Vec laneIndices() noexcept
+    {
+        alignas (Vec::SIMDRegisterSize) SampleType indices[lanes];
+
+        for (int l = 0; l < lanes; ++l)
+            indices[l] = (SampleType) l;
+
+        return Vec::fromRawArray (indices);
+    }
+
+    template <typename Callback>
+    static void withFlag (bool flag, Callback&& callback)
+    {
+        if (flag)
+            callback (std::true_type{});
+        else
+            callback (std::false_type{});
+    }
+
+    template <typename Callback>
+    static void withAccuracy (CronchAccuracy accuracy, Callback&& callback)
+    {
+        switch (accuracy)
+        {
+            case CronchAccuracy::fast:   callback (std::integral_constant<CronchAccuracy, CronchAccuracy::fast>{});      break;
+            case CronchAccuracy::table:  callback (std::integral_constant<CronchAccuracy, CronchAccuracy::table>{});     break;
+            default:                     callback (std::integral_constant<CronchAccuracy, CronchAccuracy::reference>{}); break;
+        }
+    }
+
+    /** Turns this block's parameters into a Stages type and calls back with it.
+
+        Choices that can't affect a pass are pinned rather than dispatched on, so
+        they don't multiply the instantiations: without the mix the octave and dry
+        flags are ignored, without the shaper so are the accuracy and ABSOLUTION,
+        and the ABSOLUTION gate never evaluates the curve, so its accuracy is moot.
+    */
+    template <bool mix, bool shaper, typename Callback>
+    static void dispatch (const Parameters& params, Callback&& callback)
+    {
+        const auto absolution = shaper && params.absolutionOn;
+
+        withAccuracy (shaper && ! absolution ? params.cronchAccuracy : CronchAccuracy::reference, [&] (auto accuracy)
+        {
+            withFlag (! params.isSteady(), [&] (auto ramping)
+            {
+                withFlag (absolution, [&] (auto absolutionOn)
+                {
+                    if constexpr (mix)
+                    {
+                        withFlag (params.isOctaveActive(), [&] (auto octave)
+                        {
+                            withFlag (params.isDryActive(), [&] (auto dry)
+                            {
+                                callback (Stages<decltype (accuracy)::value, decltype (ramping)::value, shaper,
+                                                 decltype (absolutionOn)::value, decltype (octave)::value, decltype (dry)::value>{});
+                            });
+                        });
+                    }
+                    else
+                    {
+                        callback (Stages<decltype (accuracy)::value, decltype (ramping)::value, shaper,
+                                         decltype (absolutionOn)::value, true, true>{});
+                    }
+                });
+            });
+        });
+    }
+
+    /** Where CRONCH's argument is clamped. The fast and table tiers only reach
+        float accuracy, so they stop at the float limit even for double.
+    */
+    template <CronchAccuracy accuracy>
+    static constexpr SampleType argumentLimit() noexcept
+    {
+        return accuracy == CronchAccuracy::reference ? FastExp::maxArgumentFor<SampleType>()
+                                                     : (SampleType) FastExp::maxArgument;
+    }
+
+    /** 1 - exp(-u) for u in [0, argumentLimit()]. */
+    template <CronchAccuracy accuracy>
+    static inline Vec cronchMagnitude (Vec u) noexcept
+    {
+        if constexpr (accuracy == CronchAccuracy::table)
+        {
+            alignas (Vec::SIMDRegisterSize) SampleType values[lanes];
+            u.copyToRawArray (values);
+
+            for (auto& v : values)
+                v = (SampleType) DefaultCronchTable::lookup ((float) v);
+
+            return Vec::fromRawArray (values);
+        }
+        else if constexpr (accuracy == CronchAccuracy::fast)
+        {
+            return Vec::expand (1) - FastExp::expNegativeFast (u);
+        }
+        else
+        {
+            return Vec::expand (1) - FastExp::expNegativeReference (u);
+        }
+    }
+
+    /** The amount must already be clamped to [0.01, 100]; the processor does that
+        before it reaches the smoother.
+    */
+    template <CronchAccuracy accuracy>
+    static inline Vec cronch (Vec x, Vec amount, Vec dcOffset) noexcept
+    {
+        const auto u = Vec::min (Vec::abs (x) * amount, Vec::expand (argumentLimit<accuracy>()));
+
+        // 1 - exp(-u) stays within [0, 1] for u >= 0, so the clamp in the scalar
+        // version never changes the result here and only the sign needs copying.
+        const auto negative = Vec::lessThan (x + dcOffset, Vec::expand (0));
+        return cronchMagnitude<accuracy> (u) ^ (negative & signMask());
+    }
+
+    static inline Vec cronchAbsolution (Vec x, Vec amount, Vec dcOffset, Vec argumentThreshold) noexcept
+    {
+        const auto above    = Vec::greaterThan (Vec::abs (x) * amount, argumentThreshold);
+        const auto negative = Vec::lessThan (x + dcOffset, Vec::expand (0));
+        return (Vec::expand (1) ^ (negative & signMask())) & above;
+    }
+
+    template <typename Stages>
+    static inline Vec shape (Vec x, Vec amount, Vec dcOffset, Vec argumentThreshold) noexcept
+    {
+        if constexpr (Stages::absolution)
+            return cronchAbsolution (x, amount, dcOffset, argumentThreshold);
+        else
+            return cronch<Stages::accuracy> (x, amount, dcOffset);
+    }
+
+    template <bool applyShaper>
+    void processGroups (SampleType* const* channels, int numChannels, int numSamples,
+                        const OchoCoefficientEngine<SampleType>& coefficients, const Parameters& params) noexcept
+    {
+        jassert (numChannels <= getNumChannels());
+
+        const auto ramp = coefficients.getRamp();
+        const auto cascade = ramp.endSection - ramp.firstSection > 1;
+
+        for (int first = 0, g = 0; first < numChannels; first += lanes, ++g)
+        {
+            auto& state = groups[(size_t) g];
+            const auto numActive = juce::jmin (lanes, numChannels - first);
+
+            dispatch<true, applyShaper> (params, [&] (auto stages)
+            {
+                if (cascade)
+                    processGroup<decltype (stages), true> (state, channels + first, numActive, numSamples, ramp, params);
+                else
+                    processGroup<decltype (stages), false> (state, channels + first, numActive, numSamples, ramp, params);
+            });
+        }
+    }
+
+    void processShaperADAA (juce::dsp::AudioBlock<SampleType>& block, const Parameters& params) noexcept
+    {
+        jassert (block.getNumChannels() <= adaaStates.size());
+
+        const auto numSamples = (int) block.getNumSamples();
+
+        if (numSamples == 0)
+            return;
+
+        // The antiderivatives assume one fixed curve, so ADAA follows the
+        // smoothed parameters a block at a time rather than per sample
+        const CronchAntiderivative shaper (params.cronchAmount.value, params.dcOffset.value, params.absolutionOn,
+                                           params.absolutionGate.value);
+
+        for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+        {
+            auto* data = block.getChannelPointer (channel);
+            auto& state = adaaStates[channel];
+
+            // coming from the plain shaper, the history is stale: start from a flat line
+            if (! adaaPrimed)
+                state.x1 = state.x2 = (double) data[0];
+
+            CronchADAA::process (data, numSamples, state, shaper, params.antialiasing);
+        }
+
+        adaaPrimed = true;
+    }
+
+    /** Each register holds consecutive samples, so a ramping parameter is spread
+        across the lanes as value + increment * lane.
+    */
+    template <typename Stages>
+    static void processShaperBlock (juce::dsp::AudioBlock<SampleType>& block, const Parameters& params) noexcept
+    {
+        const auto numSamples = (int) block.getNumSamples();
+        const auto indices = laneIndices();
+
+        alignas (Vec::SIMDRegisterSize) SampleType frame[lanes];
+
+        for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+        {
+            auto* data = block.getChannelPointer (channel);
+            auto amount = params.cronchAmount, dcOffset = params.dcOffset, gate = params.absolutionGate;
+
+            for (int i = 0; i < numSamples; i += lanes)
+            {
+                const auto n = juce::jmin (lanes, numSamples - i);
+                std::fill (std::copy (data + i, data + i + n, frame), frame + lanes, (SampleType) 0);
+
+                const auto mixed = Vec::fromRawArray (frame);
+                Vec output;
+
+                if constexpr (Stages::ramping)
+                {
+                    output = shape<Stages> (mixed, indices * amount.increment + amount.value,
+                                            indices * dcOffset.increment + dcOffset.value,
+                                            indices * gate.increment + gate.value);
+                    amount.advance (lanes);
+                    dcOffset.advance (lanes);
+                    gate.advance (lanes);
+                }
+                else
+                {
+                    output = shape<Stages> (mixed, Vec::expand (amount.value), Vec::expand (dcOffset.value), Vec::expand (gate.value));
+                }
+
+                output.copyToRawArray (frame);
+                std::copy (frame, frame + n, data + i);
+            }
+        }
+    }
+
+    /** One transposed direct form II biquad step, for every lane at once. */
+    static inline Vec processBiquad (Vec input, const OchoCoefficients<SampleType>& c, Vec& s1, Vec& s2) noexcept
+    {
+        const auto output = input * c.b0 + s1;
+        s1 = input * c.b1 - output * c.a1 + s2;
+        s2 = input * c.b2 - output * c.a2;
+        return output;
+    }
+
+    /** Each chunk is filtered across channels, then run through the flip-flops
+        along time, then mixed and shaped across channels again. The chunk is
+        short enough for its scratch to stay in L1.
+
+        With a single live filter section its state is kept in locals, so the
+        default slope costs exactly one biquad. A cascade walks the live
+        sections inside the same per-sample loop instead of making extra passes.
+    */
+    template <typename Stages, bool cascade>
+    static void processGroup (LaneState& state, SampleType* const* channels, int numActive, int numSamples,
+                              typename OchoCoefficientEngine<SampleType>::Ramp ramp, const Parameters& params) noexcept
+    {
+        const auto zero = Vec::expand (0);
+
+        // every group replays its own copy of the ramps
+        auto dry = params.dryLevel, octave = params.octaveLevel, octave2 = params.octave2Level, octave3 = params.octave3Level;
+        auto amount = params.cronchAmount, dcOffset = params.dcOffset, gate = params.absolutionGate;
+
+        const auto numOctaveStages = params.getNumOctaveStages();
+
+        if constexpr (Stages::octave)
+        {
+            // the filter hasn't seen the input while the octave path was off, so
+            // start it again from rest rather than from whatever it held back then
+            if (state.ochoIdle)
+            {
+                state.s1.fill (zero);
+                state.s2.fill (zero);
+
+                for (auto& f : state.flipFlops)
+                    for (auto& stage : f.stages)
+                        stage.lastInput = stage.pending = 0;
+            }
+
+            // likewise for divider stages that aren't running
+            for (auto& f : state.flipFlops)
+                for (auto k = (size_t) numOctaveStages; k < f.stages.size(); ++k)
+                    f.stages[k].lastInput = f.stages[k].pending = 0;
+
+            state.ochoIdle = false;
+        }
+        else
+        {
+            state.ochoIdle = true;
+        }
+
+        // sections outside the live range pass their input straight through, so
+        // any state they hold from before the response changed is stale
+        const auto firstSection = (size_t) ramp.firstSection, endSection = (size_t) ramp.endSection;
+
+        for (size_t k = 0; k < (size_t) Cascade::maxSections; ++k)
+            if (k < firstSection || k >= endSection)
+                state.s1[k] = state.s2[k] = zero;
+
+        auto s1 = state.s1, s2 = state.s2;
+        auto s1First = s1[firstSection], s2First = s2[firstSection];
+
+        alignas (Vec::SIMDRegisterSize) SampleType inFrame[lanes] = {};
+        alignas (Vec::SIMDRegisterSize) SampleType ochoFrame[lanes] = {};
+        alignas (Vec::SIMDRegisterSize) SampleType outFrame[lanes] = {};
+
+        // planar per channel; previous and ocho have room for the sample before the chunk
+        alignas (Vec::SIMDRegisterSize) SampleType filtered[lanes][chunkSize];
+        alignas (Vec::SIMDRegisterSize) SampleType previous[lanes][chunkSize + lanes];
+        alignas (Vec::SIMDRegisterSize) SampleType ocho[maxOctaveStages][lanes][lanes + chunkSize];
+
+        for (int start = 0; start < numSamples; start += chunkSize)
+        {
+            const auto numChunkSamples = juce::jmin (chunkSize, numSamples - start);
+
+            if constexpr (Stages::octave)
+            {
+                // Ocho pre-filter
+                for (int i = 0; i < numChunkSamples; ++i)
+                {
+                    for (int c = 0; c < numActive; ++c)
+                        inFrame[c] = channels[c][start + i];
+
+                    const auto& coeffs = ramp.getNextCoefficients();
+                    auto y = processBiquad (Vec::fromRawArray (inFrame), coeffs.sections[firstSection], s1First, s2First);
+
+                    if constexpr (cascade)
+                        for (auto k = firstSection + 1; k < endSection; ++k)
+                            y = processBiquad (y, coeffs.sections[k], s1[k], s2[k]);
+
+                    y.copyToRawArray (outFrame);
+
+                    for (int c = 0; c < numActive; ++c)
+                        filtered[c][i] = previous[c][i + 1] = outFrame[c];
+                }
+
+                for (int c = 0; c < numActive; ++c)
+                {
+                    SampleType* stageOutputs[] = { ocho[0][c] + lanes, ocho[1][c] + lanes, ocho[2][c] + lanes };
+                    auto& flipFlop = state.flipFlops[(size_t) c];
+
+                    switch (numOctaveStages)
+                    {
+                        case 3:  flipFlop.template processBlock<3> (filtered[c], previous[c], stageOutputs, numChunkSamples); break;
+                        case 2:  flipFlop.template processBlock<2> (filtered[c], previous[c], stageOutputs, numChunkSamples); break;
+                        default: flipFlop.template processBlock<1> (filtered[c], previous[c], stageOutputs, numChunkSamples); break;
+                    }
+                }
+            }
+
+            for (int i = 0; i < numChunkSamples; ++i)
+            {
+                auto mixed = zero;
+
+                if constexpr (Stages::dry)
+                {
+                    for (int c = 0; c < numActive; ++c)
+                        inFrame[c] = channels[c][start + i];
+
+                    mixed = Vec::fromRawArray (inFrame) * dry.value;
+                }
+
+                if constexpr (Stages::octave)
+                {
+                    // one sample late, see OchoFlipFlop::processBlock()
+                    for (int c = 0; c < numActive; ++c)
+                        ochoFrame[c] = ocho[0][c][lanes + i - 1];
+
+                    auto octaves = Vec::fromRawArray (ochoFrame) * octave.value;
+
+                    if (numOctaveStages > 1)
+                    {
+                        for (int c = 0; c < numActive; ++c)
+                            ochoFrame[c] = ocho[1][c][lanes + i - 1];
+
+                        octaves = octaves + Vec::fromRawArray (ochoFrame) * octave2.value;
+                    }
+
+                    if (numOctaveStages > 2)
+                    {
+                        for (int c = 0; c < numActive; ++c)
+                            ochoFrame[c] = ocho[2][c][lanes + i - 1];
+
+                        octaves = octaves + Vec::fromRawArray (ochoFrame) * octave3.value;
+                    }
+
+                    if constexpr (Stages::dry)
+                        mixed = mixed + octaves;
+                    else
+                        mixed = octaves;
+                }
+
+                if constexpr (Stages::shaper)
+                    shape<Stages> (mixed, Vec::expand (amount.value), Vec::expand (dcOffset.value), Vec::expand (gate.value)).copyToRawArray (outFrame);
+                else
+                    mixed.copyToRawArray (outFrame);
+
+                if constexpr (Stages::ramping)
+                {
+                    dry.advance();
+                    octave.advance();
+                    octave2.advance();
+                    octave3.advance();
+                    amount.advance();
+                    dcOffset.advance();
+                    gate.advance();
+                }
+
+                for (int c = 0; c < numActive; ++c)
+                    channels[c][start + i] = outFrame[c];
+            }
+        }
+
+        s1[firstSection] = s1First;
+        s2[firstSection] = s2First;
+        state.s1 = s1;
+        state.s2 = s2;
+    }
+
+    std::vector<LaneState> groups;
+    std::vector<CronchADAA::State> adaaStates;
+    bool adaaPrimed = false;
+};
@@ -0,0 +1,340 @@
+/*
+  ==============================================================================
+
+    OchoFilter.h
+
+    The pre-filter that sits in front of the Ocho flip-flop, plus the engine
+    that computes and ramps its coefficients without touching the heap.
+
+    The filter is a cascade of biquads: an optional Butterworth high-pass,
+    followed by one to four sections of a 12 to 48 dB/oct Butterworth
+    low-pass. Every section runs inside the kernel's one per-sample loop, so
+    extra slope or the high-pass costs a few multiply-adds per sample rather
+    than another pass over the buffer.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/** Biquad coefficients for the Ocho pre-filter, normalised so that a0 == 1.
+    The default is an identity section that passes its input straight through.
+*/
+template <typename SampleType>
+struct OchoCoefficients
+{
+    SampleType b0 = 1, b1 = 0, b2 = 0, a1 = 0, a2 = 0;
+
+    bool isIdentity() const noexcept
+    {
+        return juce::exactlyEqual (b0, (SampleType) 1) && juce::exactlyEqual (b1, (SampleType) 0)
+                && juce::exactlyEqual (b2, (SampleType) 0) && juce::exactlyEqual (a1, (SampleType) 0)
+                && juce::exactlyEqual (a2, (SampleType) 0);
+    }
+
+    /** Same low-pass as juce::dsp::IIR::Coefficients::makeLowPass, but computed
+        in place instead of allocating a ref-counted object. Takes 1/Q, which
+        defaults to a single Butterworth section.
+    */
+    static OchoCoefficients makeLowPass (double sampleRate, float cutoff,
+                                         double invQ = juce::MathConstants<double>::sqrt2) noexcept
+    {
+        jassert (sampleRate > 0.0);
+        jassert (cutoff > 0.0f && cutoff < sampleRate * 0.5);
+
+        const auto n = 1.0 / std::tan (juce::MathConstants<double>::pi * cutoff / sampleRate);
+        const auto nSquared = n * n;
+        const auto c1 = 1.0 / (1.0 + invQ * n + nSquared);
+
+        return { (SampleType) c1,
+                 (SampleType) (c1 * 2.0),
+                 (SampleType) c1,
+                 (SampleType) (c1 * 2.0 * (1.0 - nSquared)),
+                 (SampleType) (c1 * (1.0 - invQ * n + nSquared)) };
+    }
+
+    /** Same as juce::dsp::IIR::Coefficients::makeHighPass. */
+    static OchoCoefficients makeHighPass (double sampleRate, float cutoff,
+                                          double invQ = juce::MathConstants<double>::sqrt2) noexcept
+    {
+        jassert (sampleRate > 0.0);
+        jassert (cutoff > 0.0f && cutoff < sampleRate * 0.5);
+
+        const auto n = std::tan (juce::MathConstants<double>::pi * cutoff / sampleRate);
+        const auto nSquared = n * n;
+        const auto c1 = 1.0 / (1.0 + invQ * n + nSquared);
+
+        return { (SampleType) c1,
+                 (SampleType) (c1 * -2.0),
+                 (SampleType) c1,
+                 (SampleType) (c1 * 2.0 * (nSquared - 1.0)),
+                 (SampleType) (c1 * (1.0 - invQ * n + nSquared)) };
+    }
+};
+
+//==============================================================================
+/** What the Ocho pre-filter should do, straight from the parameters. */
+struct OchoResponse
+{
+    float lowPassCutoff = 1000.0f;
+    int lowPassSections = 1;        // 1 to 4 biquads, i.e. 12 to 48 dB/oct
+    bool highPassOn = false;
+    float highPassCutoff = 80.0f;
+
+    bool operator== (const OchoResponse& other) const noexcept
+    {
+        return juce::exactlyEqual (lowPassCutoff, other.lowPassCutoff) && lowPassSections == other.lowPassSections
+                && highPassOn == other.highPassOn && juce::exactlyEqual (highPassCutoff, other.highPassCutoff);
+    }
+
+    bool operator!= (const OchoResponse& other) const noexcept     { return ! operator== (other); }
+};
+
+//==============================================================================
+/** Coefficients for every section of the cascade. Slot 0 is the high-pass and
+    slots 1 to 4 the low-pass sections, gentlest first; unused slots hold
+    identity sections.
+*/
+template <typename SampleType>
+struct OchoCascade
+{
+    static constexpr int maxSections = 5;
+    static constexpr int highPassSlot = 0;
+    static constexpr int firstLowPassSlot = 1;
+    static constexpr int maxLowPassSections = maxSections - firstLowPassSlot;
+
+    std::array<OchoCoefficients<SampleType>, (size_t) maxSections> sections;
+
+    /** 1/Q of section k (0-based) of a Butterworth low-pass built from
+        numSections biquads, i.e. 2 cos ((2k + 1) pi / 4 numSections).
+    */
+    static double butterworthInverseQ (int k, int numSections) noexcept
+    {
+        return 2.0 * std::cos (juce::MathConstants<double>::pi * (2 * k + 1) / (4.0 * numSections));
+    }
+
+    static OchoCascade make (double sampleRate, const OchoResponse& response) noexcept
+    {
+        OchoCascade cascade;
+
+        if (response.highPassOn)
+            cascade.sections[(size_t) highPassSlot] = OchoCoefficients<SampleType>::makeHighPass (sampleRate, response.highPassCutoff);
+
+        for (int k = 0; k < response.lowPassSections; ++k)
+            cascade.sections[(size_t) (firstLowPassSlot + k)]
+                = OchoCoefficients<SampleType>::makeLowPass (sampleRate, response.lowPassCutoff,
+                                                             butterworthInverseQ (k, response.lowPassSections));
+
+        return cascade;
+    }
+};
+
+//==============================================================================
+/** Per-channel state of the Ocho pre-filter, one transposed direct form II
+    biquad per section (the same structure juce::dsp::IIR::Filter uses). The
+    coefficients live in the shared OchoCoefficientEngine so that every channel
+    follows the same ramp. Scalar reference for the kernel's SIMD cascade.
+*/
+template <typename SampleType>
+struct OchoFilter
+{
+    std::array<SampleType, (size_t) OchoCascade<SampleType>::maxSections> s1 {}, s2 {};
+
+    void reset() noexcept   { s1.fill (0); s2.fill (0); }
+
+    inline SampleType processSample (SampleType input, const OchoCascade<SampleType>& cascade,
+                                     int firstSection, int endSection) noexcept
+    {
+        for (auto k = (size_t) firstSection; k < (size_t) endSection; ++k)
+        {
+            const auto& c = cascade.sections[k];
+            const auto output = c.b0 * input + s1[k];
+            s1[k] = c.b1 * input - c.a1 * output + s2[k];
+            s2[k] = c.b2 * input - c.a2 * output;
+            input = output;
+        }
+
+        return input;
+    }
+};
+
+//==============================================================================
+/** Owns the Ocho pre-filter coefficients and ramps them per sample whenever
+    the response changes.
+
+    Coefficients are only recomputed when a parameter actually changes, and a
+    change is spread over a fixed ramp by interpolating the coefficients
+    linearly. The (a1, a2) stability region of a biquad is a convex triangle, so
+    every point on the way between two stable sections is stable as well. The
+    identity section is inside it too, so changing slope or switching the
+    high-pass fades sections in and out along the same ramp.
+
+    Only the slots from firstSection to endSection are live; the kernel skips
+    the rest, so the default 12 dB/oct response still costs a single biquad.
+
+    Nothing here allocates, so it is safe to drive from processBlock once
+    prepare() has been called. The cutoffs are always float parameters; only
+    the coefficients and the ramp follow SampleType.
+*/
+template <typename SampleType>
+class OchoCoefficientEngine
+{
+public:
+    using Cascade = OchoCascade<SampleType>;
+
+    /** Walks one block's worth of the ramp. Each channel takes its own copy so
+        that all channels see identical coefficients sample by sample.
+    */
+    struct Ramp
+    {
+        Cascade current, increment, target;
+        int remaining = 0;
+        int firstSection = Cascade::firstLowPassSlot, endSection = Cascade::firstLowPassSlot + 1;
+
+        inline const Cascade& getNextCoefficients() noexcept
+        {
+            if (remaining > 0)
+            {
+                if (--remaining == 0)
+                {
+                    current = target;
+                }
+                else
+                {
+                    for (auto k = (size_t) firstSection; k < (size_t) endSection; ++k)
+                    {
+                        auto& c = current.sections[k];
+                        const auto& i = increment.sections[k];
+                        c.b0 += i.b0;
+                        c.b1 += i.b1;
+                        c.b2 += i.b2;
+                        c.a1 += i.a1;
+                        c.a2 += i.a2;
+                    }
+                }
+            }
+
+            return current;
+        }
+
+        bool isRamping() const noexcept   { return remaining > 0; }
+
+        /** Narrows the live range to the sections that aren't identity at
+            either end of the ramp.
+        */
+        void updateLiveSections() noexcept
+        {
+            firstSection = Cascade::maxSections;
+            endSection = 0;
+
+            for (int k = 0; k < Cascade::maxSections; ++k)
+            {
+                if (current.sections[(size_t) k].isIdentity() && target.sections[(size_t) k].isIdentity())
+                    continue;
+
+                firstSection = juce::jmin (firstSection, k);
+                endSection = k + 1;
+            }
+
+            if (endSection == 0)
+                firstSection = 0;
+        }
+    };
+
+    //==============================================================================
+    void prepare (double newSampleRate, const OchoResponse& initialResponse, double rampLengthSeconds = 0.02)
+    {
+        sampleRate = newSampleRate;
+        rampLength = juce::jmax (1, juce::roundToInt (rampLengthSeconds * sampleRate));
+        reset (initialResponse);
+    }
+
+    /** Jumps straight to the given response, abandoning any ramp in progress. */
+    void reset (const OchoResponse& newResponse) noexcept
+    {
+        response = clampResponse (newResponse);
+        ramp.target = ramp.current = Cascade::make (sampleRate, response);
+        ramp.increment = {};
+        ramp.remaining = 0;
+        ramp.updateLiveSections();
+    }
+
+    /** Starts a ramp towards a new response. Cheap when nothing has changed. */
+    void setResponse (const OchoResponse& newResponse) noexcept
+    {
+        const auto clamped = clampResponse (newResponse);
+
+        if (clamped == response)
+            return;
+
+        response = clamped;
+        ramp.target = Cascade::make (sampleRate, response);
+
+        const auto scale = (SampleType) 1 / (SampleType) rampLength;
+
+        for (size_t k = 0; k < (size_t) Cascade::maxSections; ++k)
+        {
+            const auto& t = ramp.target.sections[k];
+            const auto& c = ramp.current.sections[k];
+            ramp.increment.sections[k] = { (t.b0 - c.b0) * scale, (t.b1 - c.b1) * scale, (t.b2 - c.b2) * scale,
+                                           (t.a1 - c.a1) * scale, (t.a2 - c.a2) * scale };
+        }
+
+        ramp.remaining = rampLength;
+        ramp.updateLiveSections();
+    }
+
+    /** Returns a copy of the ramp positioned at the start of the current block. */
+    Ramp getRamp() const noexcept               { return ramp; }
+
+    /** Moves the shared ramp on once every channel has consumed the block. */
+    void advance (int numSamples) noexcept
+    {
+        if (! ramp.isRamping())
+            return;
+
+        if (numSamples >= ramp.remaining)
+        {
+            ramp.current = ramp.target;
+            ramp.remaining = 0;
+            ramp.updateLiveSections();
+            return;
+        }
+
+        const auto steps = (SampleType) numSamples;
+
+        for (auto k = (size_t) ramp.firstSection; k < (size_t) ramp.endSection; ++k)
+        {
+            auto& c = ramp.current.sections[k];
+            const auto& i = ramp.increment.sections[k];
+            c.b0 += i.b0 * steps;
+            c.b1 += i.b1 * steps;
+            c.b2 += i.b2 * steps;
+            c.a1 += i.a1 * steps;
+            c.a2 += i.a2 * steps;
+        }
+
+        ramp.remaining -= numSamples;
+    }
+
+    const OchoResponse& getResponse() const noexcept    { return response; }
+
+private:
+    OchoResponse clampResponse (OchoResponse r) const noexcept
+    {
+        // keep the bilinear transform well away from Nyquist at low sample rates
+        const auto highest = (float) (sampleRate * 0.49);
+        r.lowPassCutoff = juce::jlimit (1.0f, highest, r.lowPassCutoff);
+        r.highPassCutoff = juce::jlimit (1.0f, highest, r.highPassCutoff);
+        r.lowPassSections = juce::jlimit (1, Cascade::maxLowPassSections, r.lowPassSections);
+        return r;
+    }
+
+    double sampleRate = 44100.0;
+    int rampLength = 1;
+    OchoResponse response;
+    Ramp ramp;
+};
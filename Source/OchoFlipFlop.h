@@ -0,0 +1,217 @@
+/*
+  ==============================================================================
+
+    OchoFlipFlop.h
+
+    Band-limiting for the Ocho octave divider.
+
+    The flip-flop multiplies the filtered signal by +/-1 and flips on each
+    positive-going zero crossing. Because the flip happens where the signal is
+    zero, the product is continuous, but its slope jumps: every period gets a
+    corner like |x|. Sampled naively, that corner aliases. A two-point
+    polyBLAMP residual, centred on the fractional crossing position, rounds
+    the corner off over the samples either side of it.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+struct OchoPolyBLAMP
+{
+    /** Where the crossing falls between the previous sample (x0 < 0) and the
+        current one (x1 >= 0), as the distance back from the current sample, in
+        [0, 1]. Uses linear interpolation between the two samples.
+    */
+    template <typename SampleType>
+    static inline SampleType crossingDistance (SampleType x0, SampleType x1) noexcept
+    {
+        return x1 / (x1 - x0);
+    }
+
+    /** Two-point polyBLAMP residual, (1 - |t|)^3 / 6, at the sample before the
+        corner (t = -(1 - d)) and at the sample after it (t = d).
+    */
+    template <typename SampleType>
+    static inline SampleType residualBefore (SampleType d) noexcept   { return d * d * d * (SampleType) (1.0 / 6.0); }
+
+    template <typename SampleType>
+    static inline SampleType residualAfter (SampleType d) noexcept    { const auto e = 1 - d; return e * e * e * (SampleType) (1.0 / 6.0); }
+
+    /** Adds the corner correction for one crossing to the held previous output
+        and the current output.
+
+        Before the crossing the output is -flip * x, after it +flip * x, so the
+        slope jumps by 2 * flip * (x1 - x0) per sample.
+    */
+    template <typename SampleType>
+    static inline void apply (SampleType& previous, SampleType& current, SampleType x0, SampleType x1, SampleType newFlip) noexcept
+    {
+        const auto d = crossingDistance (x0, x1);
+        const auto slopeJump = 2 * newFlip * (x1 - x0);
+
+        previous += slopeJump * residualBefore (d);
+        current  += slopeJump * residualAfter (d);
+    }
+};
+
+//==============================================================================
+/** The flip-flop divider chain for one channel, processed a block at a time.
+
+    Stage 1 flips the filtered signal on its positive-going zero crossings,
+    giving the octave below. Each further stage does the same to the raw
+    output of the stage before it, so -2 and -3 octaves come from the same
+    filtered signal without filtering again. A stage's output carries the
+    corners of every stage before it as well as its own, so each polyBLAMP
+    correction is added to its own stage and, with the downstream flips
+    applied, to every stage after it.
+
+    Crossings are found Vec::size() samples per register. Most registers have
+    none in any stage, so the whole register takes the flips carried in from
+    the last one. A register that does cross is stepped lane by lane, which is
+    the prefix XOR of its crossings. Its polyBLAMP corrections are applied in
+    the same sparse pass. Stage 1 is bit-identical to running processOcho()
+    and OchoPolyBLAMP::apply() one sample at a time, which Tools/OchoCheck
+    verifies.
+*/
+template <typename SampleType>
+struct OchoFlipFlop
+{
+    using Vec = juce::dsp::SIMDRegister<SampleType>;
+    static constexpr int lanes = (int) Vec::SIMDNumElements;
+    static constexpr int maxStages = 3;
+
+    struct Stage
+    {
+        SampleType lastInput = 0;   // last input sample, for zero-crossing detection
+        SampleType flip = 1;        // always +1 or -1
+        SampleType pending = 0;     // output held back one sample for the polyBLAMP correction
+    };
+
+    std::array<Stage, (size_t) maxStages> stages;
+
+    /** Fills ocho[k][0 .. numSamples) with the output of stage k, and writes
+        the held sample from the previous block to ocho[k][-1], which the
+        caller outputs first. The octave path therefore runs one sample late, so
+        that a corner can also correct the sample before its crossing.
+
+        filtered, previous and every ocho[k] must be Vec-aligned. previous[i + 1]
+        must hold filtered[i]; previous[0] is filled in from the first stage.
+    */
+    template <int numStages>
+    void processBlock (const SampleType* filtered, SampleType* previous, SampleType* const* ocho, int numSamples) noexcept
+    {
+        static_assert (numStages >= 1 && numStages <= maxStages);
+
+        if (numSamples <= 0)
+            return;
+
+        previous[0] = stages[0].lastInput;
+
+        for (size_t k = 0; k < (size_t) numStages; ++k)
+            ocho[k][-1] = stages[k].pending;
+
+        const auto zero = Vec::expand (0);
+        const auto vectorised = numSamples - numSamples % lanes;
+        int i = 0;
+
+        for (; i < vectorised; i += lanes)
+        {
+            // a stage that doesn't cross in this register holds one flip across it,
+            // so the next stage's input and its one-sample delay are plain multiplies
+            std::array<Vec, (size_t) numStages> outputs;
+            auto x = Vec::fromRawArray (filtered + i);
+            auto before = Vec::fromRawArray (previous + i);
+            auto crossed = false;
+
+            for (size_t k = 0; k < (size_t) numStages && ! crossed; ++k)
+            {
+                const auto crossing = Vec::lessThan (before, zero) & Vec::greaterThanOrEqual (x, zero);
+                crossed = (Vec::expand (1) & crossing).sum() != 0;
+
+                const auto flip = Vec::expand (stages[k].flip);
+                x = x * flip;
+                before = before * flip;
+                outputs[k] = x;
+            }
+
+            if (crossed)
+            {
+                for (int l = 0; l < lanes; ++l)
+                    processSample<numStages> (filtered, ocho, i + l);
+
+                continue;
+            }
+
+            auto input = filtered[i + lanes - 1];
+
+            for (size_t k = 0; k < (size_t) numStages; ++k)
+            {
+                outputs[k].copyToRawArray (ocho[k] + i);
+                stages[k].lastInput = input;
+                input = input * stages[k].flip;
+            }
+        }
+
+        for (; i < numSamples; ++i)
+            processSample<numStages> (filtered, ocho, i);
+
+        for (size_t k = 0; k < (size_t) numStages; ++k)
+            stages[k].pending = ocho[k][numSamples - 1];
+    }
+
+private:
+    template <int numStages>
+    inline void processSample (const SampleType* filtered, SampleType* const* ocho, int i) noexcept
+    {
+        std::array<SampleType, (size_t) numStages> oldFlips, inputsBefore, inputsAfter;
+        std::array<bool, (size_t) numStages> crossed;
+        auto x = filtered[i];
+
+        for (size_t k = 0; k < (size_t) numStages; ++k)
+        {
+            auto& stage = stages[k];
+            oldFlips[k] = stage.flip;
+            inputsBefore[k] = stage.lastInput;
+            inputsAfter[k] = x;
+
+            // Flip only on positive-going zero crossings
+            crossed[k] = stage.lastInput < 0 && x >= 0;
+
+            if (crossed[k])
+                stage.flip = -stage.flip;
+
+            stage.lastInput = x;
+            x = x * stage.flip;
+            ocho[k][i] = x;
+        }
+
+        for (size_t m = 0; m < (size_t) numStages; ++m)
+        {
+            if (! crossed[m])
+                continue;
+
+            // same arithmetic as OchoPolyBLAMP::apply(), shared with the later stages
+            const auto d = OchoPolyBLAMP::crossingDistance (inputsBefore[m], inputsAfter[m]);
+            const auto slopeJump = 2 * stages[m].flip * (inputsAfter[m] - inputsBefore[m]);
+            const auto residualBefore = slopeJump * OchoPolyBLAMP::residualBefore (d);
+            const auto residualAfter = slopeJump * OchoPolyBLAMP::residualAfter (d);
+            SampleType signBefore = 1, signAfter = 1;
+
+            for (auto k = m; k < (size_t) numStages; ++k)
+            {
+                if (k > m)
+                {
+                    signBefore *= oldFlips[k];
+                    signAfter *= stages[k].flip;
+                }
+
+                ocho[k][i - 1] += residualBefore * signBefore;
+                ocho[k][i]     += residualAfter * signAfter;
+            }
+        }
+    }
+};
@@ -27,23 +27,63 @@ void styleSliderColor(juce::Slider& slider, juce::Colour color)
     slider.setColour(juce::Slider::rotarySliderOutlineColourId, dark);
 }
 
+// ComboBoxAttachment only selects items, so the box is filled from the parameter's choices first
+static void addParameterChoices(juce::ComboBox& box, juce::AudioProcessorValueTreeState& state, const juce::String& parameterID)
+{
+    if (auto* choice = dynamic_cast<juce::AudioParameterChoice*>(state.getParameter(parameterID)))
+        box.addItemList(choice->choices, 1);
+}
+
+//==============================================================================
+void LoadMeterDisplay::timerCallback()
+{
+    auto stats = meter.getStatistics();
+    auto percent = [](float load) { return juce::String(juce::roundToInt(load * 100.0f)) + "%"; };
+
+    // Green with headroom, yellow from 50%, red once the recent peak nears the deadline
+    auto newColour = stats.peak > 0.8f ? juce::Colours::red
+                   : stats.peak > 0.5f ? juce::Colours::yellow
+                                       : juce::Colours::green;
+
+    juce::String newText = "DSP " + percent(stats.average)
+                         + "  PEAK " + percent(stats.peak)
+                         + "  P99 " + percent(stats.p99)
+                         + "  MAX " + percent(stats.worst);
+
+    if (stats.numOverruns > 0)
+        newText << "  OVER " << (juce::int64) stats.numOverruns;
+
+    if (newText != text || newColour != colour)
+    {
+        text = newText;
+        colour = newColour;
+        repaint();
+    }
+}
+
+void LoadMeterDisplay::paint(juce::Graphics& g)
+{
+    g.setColour(colour);
+    g.setFont(getVCRFont(12.0f));
+    g.drawText(text, getLocalBounds(), juce::Justification::centredRight);
+}
+
 //==============================================================================
 INTRUSIONAudioProcessorEditor::INTRUSIONAudioProcessorEditor (INTRUSIONAudioProcessor& p)
-: AudioProcessorEditor (&p), absoluteGraph(p), audioProcessor (p)
+: AudioProcessorEditor (&p), absoluteGraph(p), loadMeterDisplay(p.getLoadMeter()), audioProcessor (p)
 {
-    // Make sure that before the constructor has finished, you've set the
-    // editor's size to whatever you need it to be.
-    setSize (400, 400);
+    setOpaque(true);
+    addAndMakeVisible(content);
     
     titleLabel.setText("INTRUSION", juce::dontSendNotification);
     titleLabel.setFont(getVCRFont(24.0f));
     titleLabel.setJustificationType(juce::Justification::centred);
-    addAndMakeVisible(titleLabel);
+    content.addAndMakeVisible(titleLabel);
     
     cronchAmountSlider.setSliderStyle(juce::Slider::RotaryHorizontalVerticalDrag);
     cronchAmountSlider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 60, 20);
     cronchAmountSlider.setRange(0.0f, 20.0f, 0.01f);
-    addAndMakeVisible(cronchAmountSlider);
+    content.addAndMakeVisible(cronchAmountSlider);
 
     cronchAmountAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
         audioProcessor.parameters, "cronchAmount", cronchAmountSlider);
@@ -51,65 +91,105 @@ INTRUSIONAudioProcessorEditor::INTRUSIONAudioProcessorEditor (INTRUSIONAudioProc
     
     absoluteOffsetSlider.setSliderStyle(juce::Slider::RotaryHorizontalVerticalDrag);
     absoluteOffsetSlider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 60, 20);
-    addAndMakeVisible(absoluteOffsetSlider);
+    content.addAndMakeVisible(absoluteOffsetSlider);
 
     absoluteOffsetAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
         audioProcessor.parameters, "absoluteOffset", absoluteOffsetSlider);
     
-    addAndMakeVisible(absoluteGraph);
+    content.addAndMakeVisible(absoluteGraph);
     
     // Dry Level Slider
     dryLevelSlider.setSliderStyle(juce::Slider::RotaryHorizontalVerticalDrag);
     dryLevelSlider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 60, 20);
-    addAndMakeVisible(dryLevelSlider);
+    content.addAndMakeVisible(dryLevelSlider);
     dryLevelAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
         audioProcessor.parameters, "dryLevel", dryLevelSlider);
 
     // Octave Level Slider
     octaveLevelSlider.setSliderStyle(juce::Slider::RotaryHorizontalVerticalDrag);
     octaveLevelSlider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 60, 20);
-    addAndMakeVisible(octaveLevelSlider);
+    content.addAndMakeVisible(octaveLevelSlider);
     octaveLevelAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
         audioProcessor.parameters, "octaveLevel", octaveLevelSlider);
+
+    // -2 and -3 Octave Level Sliders
+    octave2LevelSlider.setSliderStyle(juce::Slider::LinearVertical);
+    octave2LevelSlider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 60, 20);
+    content.addAndMakeVisible(octave2LevelSlider);
+    octave2LevelAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
+        audioProcessor.parameters, "octave2Level", octave2LevelSlider);
+
+    octave3LevelSlider.setSliderStyle(juce::Slider::LinearVertical);
+    octave3LevelSlider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 60, 20);
+    content.addAndMakeVisible(octave3LevelSlider);
+    octave3LevelAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
+        audioProcessor.parameters, "octave3Level", octave3LevelSlider);
     
     // Labels
     cronchAmountLabel.setText("CRONCH", juce::dontSendNotification);
     cronchAmountLabel.attachToComponent(&cronchAmountSlider, false);
-    addAndMakeVisible(cronchAmountLabel);
+    content.addAndMakeVisible(cronchAmountLabel);
 
     absoluteOffsetLabel.setText("DC FUCK", juce::dontSendNotification);
     absoluteOffsetLabel.attachToComponent(&absoluteOffsetSlider, false);
-    addAndMakeVisible(absoluteOffsetLabel);
+    content.addAndMakeVisible(absoluteOffsetLabel);
 
     dryLevelLabel.setText("0", juce::dontSendNotification);
     dryLevelLabel.attachToComponent(&dryLevelSlider, false);
-    addAndMakeVisible(dryLevelLabel);
+    content.addAndMakeVisible(dryLevelLabel);
 
     octaveLevelLabel.setText("-8", juce::dontSendNotification);
     octaveLevelLabel.attachToComponent(&octaveLevelSlider, false);
-    addAndMakeVisible(octaveLevelLabel);
+    content.addAndMakeVisible(octaveLevelLabel);
+
+    octave2LevelLabel.setText("-16", juce::dontSendNotification);
+    octave2LevelLabel.attachToComponent(&octave2LevelSlider, false);
+    content.addAndMakeVisible(octave2LevelLabel);
+
+    octave3LevelLabel.setText("-24", juce::dontSendNotification);
+    octave3LevelLabel.attachToComponent(&octave3LevelSlider, false);
+    content.addAndMakeVisible(octave3LevelLabel);
     
     dryLevelSlider.setSliderStyle(juce::Slider::LinearVertical);
     octaveLevelSlider.setSliderStyle(juce::Slider::LinearVertical);
     
     ochoLPFSlider.setSliderStyle(juce::Slider::RotaryHorizontalVerticalDrag);
     ochoLPFSlider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 60, 20);
-    addAndMakeVisible(ochoLPFSlider);
+    content.addAndMakeVisible(ochoLPFSlider);
     ochoLPFAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
         audioProcessor.parameters, "ochoLPFCutoff", ochoLPFSlider);
     ochoLPFLabel.setText("Pre-Filter", juce::dontSendNotification);
     ochoLPFLabel.attachToComponent(&ochoLPFSlider, false);
-    addAndMakeVisible(ochoLPFLabel);
+    content.addAndMakeVisible(ochoLPFLabel);
+
+    addParameterChoices(ochoSlopeBox, audioProcessor.parameters, "ochoSlope");
+    content.addAndMakeVisible(ochoSlopeBox);
+    ochoSlopeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+        audioProcessor.parameters, "ochoSlope", ochoSlopeBox);
+
+    ochoHPFSlider.setSliderStyle(juce::Slider::RotaryHorizontalVerticalDrag);
+    ochoHPFSlider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 60, 20);
+    content.addAndMakeVisible(ochoHPFSlider);
+    ochoHPFAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
+        audioProcessor.parameters, "ochoHPFCutoff", ochoHPFSlider);
+    ochoHPFLabel.setText("HPF", juce::dontSendNotification);
+    ochoHPFLabel.attachToComponent(&ochoHPFSlider, false);
+    content.addAndMakeVisible(ochoHPFLabel);
+
+    ochoHPFToggle.setButtonText("ON");
+    content.addAndMakeVisible(ochoHPFToggle);
+    ochoHPFToggleAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(
+        audioProcessor.parameters, "ochoHPFOn", ochoHPFToggle);
     
     absolutionToggle.setButtonText("ABSOLUTION");
-    addAndMakeVisible(absolutionToggle);
+    content.addAndMakeVisible(absolutionToggle);
     absolutionToggleAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(
         audioProcessor.parameters, "absolutionOn", absolutionToggle);
     
     absolutionThresholdSlider.setSliderStyle(juce::Slider::RotaryHorizontalVerticalDrag);
     absolutionThresholdSlider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 60, 20);
     absolutionThresholdSlider.setRange(0.0f, 1.0f, 0.01f);
-    addAndMakeVisible(absolutionThresholdSlider);
+    content.addAndMakeVisible(absolutionThresholdSlider);
 
     absolutionThresholdAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
         audioProcessor.parameters, "absolutionThreshold", absolutionThresholdSlider);
@@ -117,7 +197,32 @@ INTRUSIONAudioProcessorEditor::INTRUSIONAudioProcessorEditor (INTRUSIONAudioProc
     absolutionThresholdLabel.setText("Gate", juce::dontSendNotification);
     absolutionThresholdLabel.attachToComponent(&absolutionThresholdSlider, false);
     absolutionThresholdLabel.setFont(getVCRFont(14.0f));
-    addAndMakeVisible(absolutionThresholdLabel);
+    content.addAndMakeVisible(absolutionThresholdLabel);
+
+    // Engine settings: oversampling, anti-aliasing and the CRONCH shaper's quality tier
+    addParameterChoices(oversamplingBox, audioProcessor.parameters, "oversampling");
+    content.addAndMakeVisible(oversamplingBox);
+    oversamplingAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+        audioProcessor.parameters, "oversampling", oversamplingBox);
+    oversamplingLabel.setText("OVERSAMPLE", juce::dontSendNotification);
+    oversamplingLabel.attachToComponent(&oversamplingBox, false);
+    content.addAndMakeVisible(oversamplingLabel);
+
+    addParameterChoices(antialiasingBox, audioProcessor.parameters, "antialiasing");
+    content.addAndMakeVisible(antialiasingBox);
+    antialiasingAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+        audioProcessor.parameters, "antialiasing", antialiasingBox);
+    antialiasingLabel.setText("ANTIALIAS", juce::dontSendNotification);
+    antialiasingLabel.attachToComponent(&antialiasingBox, false);
+    content.addAndMakeVisible(antialiasingLabel);
+
+    addParameterChoices(cronchQualityBox, audioProcessor.parameters, "cronchQuality");
+    content.addAndMakeVisible(cronchQualityBox);
+    cronchQualityAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+        audioProcessor.parameters, "cronchQuality", cronchQualityBox);
+    cronchQualityLabel.setText("QUALITY", juce::dontSendNotification);
+    cronchQualityLabel.attachToComponent(&cronchQualityBox, false);
+    content.addAndMakeVisible(cronchQualityLabel);
     
     auto font = getVCRFont(14.0f);
 
@@ -125,10 +230,37 @@ INTRUSIONAudioProcessorEditor::INTRUSIONAudioProcessorEditor (INTRUSIONAudioProc
     absoluteOffsetLabel.setFont(font);
     dryLevelLabel.setFont(font);
     octaveLevelLabel.setFont(font);
+    octave2LevelLabel.setFont(font);
+    octave3LevelLabel.setFont(font);
     ochoLPFLabel.setFont(font);
+    ochoHPFLabel.setFont(font);
+    oversamplingLabel.setFont(font);
+    antialiasingLabel.setFont(font);
+    cronchQualityLabel.setFont(font);
+
+    content.addAndMakeVisible(loadMeterDisplay);
+
+    // Everything that only changes when it's touched is rendered once and then blitted,
+    // so the graph and meter repaints don't redraw the knobs and text around them
+    for (juce::Component* c : std::initializer_list<juce::Component*> {
+             &titleLabel, &cronchAmountSlider, &absoluteOffsetSlider, &dryLevelSlider, &octaveLevelSlider,
+             &octave2LevelSlider, &octave3LevelSlider, &ochoLPFSlider, &ochoSlopeBox, &ochoHPFSlider, &ochoHPFToggle,
+             &absolutionToggle, &absolutionThresholdSlider, &oversamplingBox, &antialiasingBox, &cronchQualityBox,
+             &cronchAmountLabel, &absoluteOffsetLabel, &dryLevelLabel, &octaveLevelLabel,
+             &octave2LevelLabel, &octave3LevelLabel, &ochoLPFLabel, &ochoHPFLabel, &absolutionThresholdLabel,
+             &oversamplingLabel, &antialiasingLabel, &cronchQualityLabel })
+        c->setBufferedToImage(true);
+
+    content.addAndMakeVisible(crtOverlay);
+
+    // Resizable at the design aspect ratio, from 0.75x to 3x
+    setResizable(true, true);
+    setResizeLimits(designWidth * 3 / 4, designHeight * 3 / 4, designWidth * 3, designHeight * 3);
+    getConstrainer()->setFixedAspectRatio((double)designWidth / designHeight);
 
-    addAndMakeVisible(crtOverlay);
-    crtOverlay.setInterceptsMouseClicks(false, false); // Let clicks pass through
+    // Make sure that before the constructor has finished, you've set the
+    // editor's size to whatever you need it to be.
+    setSize(designWidth, designHeight);
     
     
     
@@ -148,43 +280,78 @@ void INTRUSIONAudioProcessorEditor::paint (juce::Graphics& g)
 
 void INTRUSIONAudioProcessorEditor::resized()
 {
+    // The layout below stays in design units; scaling content scales the lot, and the
+    // graph and cached layers pick up the new pixel density and re-render at it
+    float scale = juce::jmin((float)getWidth() / designWidth, (float)getHeight() / designHeight);
+
+    if (scale <= 0.0f)
+        return;
+
+    content.setBounds(0, 0, designWidth, designHeight);
+    content.setTransform(juce::AffineTransform::scale(scale));
+
+    const int width = designWidth;
+    const int height = designHeight;
     const int margin = 20;
     const int knobSize = 80;
-    const int narrowKnobWidth = 40;
+    const int smallKnobSize = 64;
+    const int narrowKnobWidth = 30;
+    const int faderGap = 4;
     const int spacing = 10;
 
     // Title
-    titleLabel.setBounds(0, 10, getWidth(), 30);
+    titleLabel.setBounds(0, 10, width, 30);
 
     // Graph - expand horizontally, leave space for left/right controls
-    int graphLeft = margin + narrowKnobWidth * 2 + spacing * 2;
-    int graphRight = getWidth() - (margin + knobSize + spacing);
+    int graphLeft = margin + narrowKnobWidth * 4 + faderGap * 3 + spacing;
+    int graphRight = width - (margin + knobSize + spacing);
     int graphWidth = graphRight - graphLeft;
     absoluteGraph.setBounds(graphLeft,
                             50,
                             graphWidth,
                             100);
 
-    // OCHO controls on left
-    dryLevelSlider.setBounds(margin, 100, narrowKnobWidth, 120);
-    octaveLevelSlider.setBounds(margin + narrowKnobWidth + spacing, 100, narrowKnobWidth, 120);
-    ochoLPFSlider.setBounds(margin, 260, knobSize, knobSize);
+    // OCHO controls on left: the dry, -8, -16 and -24 faders side by side
+    juce::Slider* faders[] = { &dryLevelSlider, &octaveLevelSlider, &octave2LevelSlider, &octave3LevelSlider };
+
+    for (int i = 0; i < 4; ++i)
+        faders[i]->setBounds(margin + i * (narrowKnobWidth + faderGap), 100, narrowKnobWidth, 120);
+
+    // Ocho's filters below them: low-pass and its slope, high-pass and its switch
+    ochoLPFSlider.setBounds(margin, 250, smallKnobSize, smallKnobSize);
+    ochoSlopeBox.setBounds(margin, 320, smallKnobSize, 20);
+    ochoHPFSlider.setBounds(margin + smallKnobSize + faderGap, 250, smallKnobSize, smallKnobSize);
+    ochoHPFToggle.setBounds(margin + smallKnobSize + faderGap, 320, smallKnobSize, 20);
 
     // ABSOLUTE controls on right
-    cronchAmountSlider.setBounds(getWidth() - margin - knobSize, 100, knobSize, knobSize);
-    absoluteOffsetSlider.setBounds(getWidth() - margin - knobSize, 210, knobSize, knobSize);
+    cronchAmountSlider.setBounds(width - margin - knobSize, 100, knobSize, knobSize);
+    absoluteOffsetSlider.setBounds(width - margin - knobSize, 210, knobSize, knobSize);
 
     // ABSOLUTION controls - move to center below graph
-    absolutionToggle.setBounds(getWidth() / 2 - knobSize / 2, 160, knobSize, 20);
-    absolutionThresholdSlider.setBounds(getWidth() / 2 - knobSize / 2, 210, knobSize, knobSize);
+    absolutionToggle.setBounds(width / 2 - knobSize / 2, 160, knobSize, 20);
+    absolutionThresholdSlider.setBounds(width / 2 - knobSize / 2, 210, knobSize, knobSize);
+
+    // Engine settings in a row beneath them, out to the right edge
+    const int settingsLeft = width / 2 - knobSize / 2;
+    const int settingsWidth = (width - margin - settingsLeft - spacing) / 3;
+    juce::ComboBox* settings[] = { &oversamplingBox, &antialiasingBox, &cronchQualityBox };
+
+    for (int i = 0; i < 3; ++i)
+        settings[i]->setBounds(settingsLeft + i * (settingsWidth + spacing / 2), 320, settingsWidth, 20);
 
     // Apply styling
     styleSliderColor(cronchAmountSlider, juce::Colours::blue);
     styleSliderColor(absoluteOffsetSlider, juce::Colours::blue);
     styleSliderColor(dryLevelSlider, juce::Colours::red);
     styleSliderColor(octaveLevelSlider, juce::Colours::red);
+    styleSliderColor(octave2LevelSlider, juce::Colours::red);
+    styleSliderColor(octave3LevelSlider, juce::Colours::red);
     styleSliderColor(ochoLPFSlider, juce::Colours::red);
+    styleSliderColor(ochoHPFSlider, juce::Colours::red);
     styleSliderColor(absolutionThresholdSlider, juce::Colours::yellow);
 
-    crtOverlay.setBounds(getLocalBounds());
+    // DSP load along the bottom edge
+    loadMeterDisplay.setBounds(margin, height - 25, width - margin * 2, 20);
+
+    crtOverlay.setBounds(content.getLocalBounds());
 }
@@ -15,78 +15,274 @@
 /**
 */
 
+// What the plugin is actually putting out: a zero-crossing-triggered scope,
+// input against output, or the spectrum (click to step through them)
 class GraphComponent : public juce::Component, private juce::Timer
 {
 public:
     GraphComponent(INTRUSIONAudioProcessor& p) : processor(p)
     {
-        startTimerHz(30); // Refresh 30 times per second
+        setOpaque(true);
+
+        // The audio thread only feeds the scope while it's open, and it starts from fresh audio
+        processor.getScopeFeed().setActive(true);
+        startTimerHz(30); // Only redraws when new audio has arrived
+    }
+
+    ~GraphComponent() override
+    {
+        processor.getScopeFeed().setActive(false);
+        processor.getSpectrumAnalyser().setActive(false);
     }
 
     void paint(juce::Graphics& g) override
     {
-        g.fillAll(juce::Colours::black);
-        g.setColour(juce::Colours::red);
+        // Painting only ever blits. The image is rendered from the timer at the pixel density
+        // last seen here, so a scale or size change shows the old image stretched for a frame
+        // rather than re-rendering inside the paint
+        auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+
+        if (! juce::approximatelyEqual(scale, cachedScale))
+        {
+            renderScale = scale;
+            needsRender = true;
+        }
+
+        if (cachedImage.isValid())
+            g.drawImage(cachedImage, getLocalBounds().toFloat());
+        else
+            g.fillAll(juce::Colours::black);
+    }
+
+    void resized() override { needsRender = true; }
+
+    void mouseDown(const juce::MouseEvent&) override
+    {
+        view = (View)(((int)view + 1) % 3);
+
+        // The analyser only runs, and the audio thread only feeds it, while it's on screen
+        processor.getSpectrumAnalyser().setActive(view == View::spectrum);
+
+        needsRender = true;
+    }
+
+private:
+    INTRUSIONAudioProcessor& processor;
+
+    // The most recent frames, oldest overwritten first
+    static constexpr int historySize = 4096;
+    std::vector<ScopeFrame> history = std::vector<ScopeFrame>(historySize);
+    std::vector<ScopeFrame> incoming = std::vector<ScopeFrame>(ScopeFeed::capacity);
+    int historyEnd = 0;
+    int silentFrames = 0;   // consecutive silent frames at the newest end of history
+
+    enum class View { scope, transfer, spectrum };
+    View view = View::scope;
+
+    SpectrumAnalyser::Spectrum spectrum {};
+    juce::Image cachedImage;
+    float cachedScale = 0.0f, renderScale = 1.0f;
+    bool needsRender = true;
+    bool renderedSilent = false;
+
+    // age 0 is the newest frame
+    const ScopeFrame& frameAt(int age) const
+    {
+        return history[(size_t)((historyEnd - 1 - age % historySize + historySize * 2) % historySize)];
+    }
+
+    void timerCallback() override
+    {
+        // The scope history is kept current in every view, so switching back shows recent audio
+        int numRead = processor.getScopeFeed().read(incoming.data(), (int)incoming.size());
 
-        auto area = getLocalBounds().toFloat();
-        auto width = area.getWidth();
-        auto height = area.getHeight();
+        for (int i = 0; i < numRead; ++i)
+        {
+            history[(size_t)historyEnd] = incoming[(size_t)i];
+            historyEnd = (historyEnd + 1) % historySize;
+            silentFrames = isSilent(incoming[(size_t)i]) ? juce::jmin(silentFrames + 1, historySize) : 0;
+        }
 
-        juce::Path waveform;
+        // The feed keeps sending frames through silence and the idle bypass, but once
+        // the whole history is silent and has been drawn that way, more silence changes nothing
+        bool historySilent = silentFrames == historySize;
+        bool changed = false;
 
-        float amount = processor.parameters.getRawParameterValue("cronchAmount")->load();
-        float dcOffset = processor.parameters.getRawParameterValue("absoluteOffset")->load();
-        float dryLevel = processor.parameters.getRawParameterValue("dryLevel")->load();
-        float octaveLevel = processor.parameters.getRawParameterValue("octaveLevel")->load();
-        bool absolutionOn = processor.parameters.getRawParameterValue("absolutionOn")->load() > 0.5f;
-        float absolutionThreshold = processor.parameters.getRawParameterValue("absolutionThreshold")->load();
+        if (view == View::spectrum)
+        {
+            // Likewise a spectrum that has settled, e.g. at the floor, isn't drawn again
+            SpectrumAnalyser::Spectrum latest;
+            changed = processor.getSpectrumAnalyser().getLatestSpectrum(latest) && latest != spectrum;
 
-        int numPoints = (int)width;
-        float lastInput = 0.0f;
-        float flipMultiplier = 1.0f;
+            if (changed)
+                spectrum = latest;
+        }
+        else
+        {
+            changed = numRead > 0 && ! (historySilent && renderedSilent);
+        }
 
-        for (int i = 0; i < numPoints; ++i)
+        if (changed || needsRender)
         {
-            float normX = (float)i / (numPoints - 1);
-            float input = std::sin(normX * juce::MathConstants<float>::twoPi * 2.0f); // 2 cycles
-            float adjustedInput = input + dcOffset;
+            needsRender = false;
+            renderImage(renderScale);
+            renderedSilent = historySilent;
+            repaint();
+        }
+        // otherwise nothing new arrived, so the cached image still stands
+    }
 
-            if (lastInput < 0.0f && adjustedInput >= 0.0f)
-                flipMultiplier = -flipMultiplier;
+    static bool isSilent(const ScopeFrame& frame)
+    {
+        auto threshold = IntrusionEngine::silenceThreshold;
+
+        return std::abs(frame.outputMin) <= threshold && std::abs(frame.outputMax) <= threshold
+            && std::abs(frame.input) <= threshold && std::abs(frame.output) <= threshold;
+    }
 
-            lastInput = adjustedInput;
+    void renderImage(float scale)
+    {
+        cachedScale = scale;
 
-            float ocho = adjustedInput * flipMultiplier;
-            float mixed = (input * dryLevel) + (ocho * octaveLevel);
-            float shaped = applyCronchToSample(mixed, amount, dcOffset);
-            float output = absolutionOn ? applyAbsolutionToSample(shaped, absolutionThreshold) : shaped;
-            float pixelY = juce::jmap(output, -1.0f, 1.0f, height, 0.0f);
+        auto width = (float)getWidth();
+        auto height = (float)getHeight();
+        int imageWidth = juce::roundToInt(width * scale);
+        int imageHeight = juce::roundToInt(height * scale);
 
-            if (i == 0)
-                waveform.startNewSubPath((float)i, pixelY);
-            else
-                waveform.lineTo((float)i, pixelY);
+        if (imageWidth <= 0 || imageHeight <= 0)
+        {
+            cachedImage = {};
+            return;
         }
 
-        g.strokePath(waveform, juce::PathStrokeType(2.0f));
+        // Only reallocated when the size or scale changes, not on every new frame of audio
+        if (cachedImage.getWidth() != imageWidth || cachedImage.getHeight() != imageHeight)
+            cachedImage = juce::Image(juce::Image::RGB, imageWidth, imageHeight, false);
+
+        juce::Graphics g(cachedImage);
+        g.addTransform(juce::AffineTransform::scale(scale));
+        g.fillAll(juce::Colours::black);
+
+        if (view == View::spectrum)
+            drawSpectrum(g, width, height);
+        else if (view == View::transfer)
+            drawTransfer(g, width, height);
+        else
+            drawScope(g, width, height);
     }
 
-private:
-    INTRUSIONAudioProcessor& processor;
+    // One frame per pixel column, drawn as its min/max span
+    void drawScope(juce::Graphics& g, float width, float height)
+    {
+        int numColumns = juce::jmin((int)width, historySize / 2);
+
+        // Trigger on the newest rising zero crossing that still has a full screen after it,
+        // so a steady note stands still; free-run if there isn't one
+        int start = numColumns - 1;
 
-    void timerCallback() override { repaint(); }
+        for (int age = numColumns; age < historySize - 1; ++age)
+        {
+            if (frameAt(age + 1).output < 0.0f && frameAt(age).output >= 0.0f)
+            {
+                start = age;
+                break;
+            }
+        }
+
+        g.setColour(juce::Colours::red.darker(2.0f));
+        g.drawHorizontalLine(juce::roundToInt(height * 0.5f), 0.0f, width);
+
+        g.setColour(juce::Colours::red);
+
+        for (int x = 0; x < numColumns; ++x)
+        {
+            const auto& frame = frameAt(start - x);
+            float top = juce::jmap(juce::jlimit(-1.0f, 1.0f, frame.outputMax), -1.0f, 1.0f, height, 0.0f);
+            float bottom = juce::jmap(juce::jlimit(-1.0f, 1.0f, frame.outputMin), -1.0f, 1.0f, height, 0.0f);
+            g.fillRect((float)x, top, 1.0f, juce::jmax(1.0f, bottom - top));
+        }
+    }
+
+    // Log frequency across, 0 to -96 dB up, with the host's Nyquist at the right edge:
+    // anything that isn't a harmonic of the note is aliasing
+    void drawSpectrum(juce::Graphics& g, float width, float height)
+    {
+        auto& analyser = processor.getSpectrumAnalyser();
+        auto nyquist = (float)analyser.getSampleRate() * 0.5f;
+        auto frequencyToX = [&](float frequency)
+        {
+            return width * std::log(frequency / SpectrumAnalyser::minFrequency) / std::log(nyquist / SpectrumAnalyser::minFrequency);
+        };
 
-    float applyCronchToSample(float x, float amount, float dcOffset)
+        g.setColour(juce::Colours::red.darker(2.0f));
+
+        for (float frequency : { 100.0f, 1000.0f, 10000.0f })
+            if (frequency < nyquist)
+                g.drawVerticalLine(juce::roundToInt(frequencyToX(frequency)), 0.0f, height);
+
+        juce::Path curve;
+        curve.startNewSubPath(0.0f, height);
+
+        for (int b = 0; b < SpectrumAnalyser::numBins; ++b)
+        {
+            float x = frequencyToX(analyser.getBinFrequency(b));
+            float y = juce::jmap(juce::jlimit(-96.0f, 0.0f, spectrum[(size_t)b]), -96.0f, 0.0f, height, 0.0f);
+            curve.lineTo(x, y);
+        }
+
+        curve.lineTo(width, height);
+        curve.closeSubPath();
+
+        g.setColour(juce::Colours::red);
+        g.fillPath(curve);
+    }
+
+    // Input across, output up: the transfer curve the signal is actually taking
+    void drawTransfer(juce::Graphics& g, float width, float height)
     {
-        amount = juce::jlimit(0.01f, 100.0f, amount);
-        float shaped = std::copysignf(1.0f - std::expf(-std::abs(x) * amount), x + dcOffset);
-        return juce::jlimit(-1.0f, 1.0f, shaped);
+        auto size = juce::jmin(width, height);
+        auto area = juce::Rectangle<float>(size, size).withCentre({ width * 0.5f, height * 0.5f });
+
+        g.setColour(juce::Colours::red.darker(2.0f));
+        g.drawHorizontalLine(juce::roundToInt(area.getCentreY()), area.getX(), area.getRight());
+        g.drawVerticalLine(juce::roundToInt(area.getCentreX()), area.getY(), area.getBottom());
+
+        // Oversampling delays the output, so each output is paired with the input it came from
+        auto& feed = processor.getScopeFeed();
+        int latencyFrames = juce::roundToInt(processor.getLatencySamples() / (double)feed.getDecimation());
+        int numPoints = historySize / 4;
+
+        g.setColour(juce::Colours::red);
+
+        for (int age = 0; age < numPoints; ++age)
+        {
+            float x = juce::jmap(juce::jlimit(-1.0f, 1.0f, frameAt(age + latencyFrames).input), -1.0f, 1.0f, area.getX(), area.getRight());
+            float y = juce::jmap(juce::jlimit(-1.0f, 1.0f, frameAt(age).output), -1.0f, 1.0f, area.getBottom(), area.getY());
+            g.fillRect(x - 0.75f, y - 0.75f, 1.5f, 1.5f);
+        }
     }
+};
 
-    float applyAbsolutionToSample(float x, float threshold)
+
+// Shows this instance's share of its real-time budget; click to reset
+class LoadMeterDisplay : public juce::Component, private juce::Timer
+{
+public:
+    LoadMeterDisplay(DSPLoadMeter& m) : meter(m)
     {
-        return std::abs(x) <= threshold ? 0.0f : (x > 0 ? 1.0f : -1.0f);
+        startTimerHz(4); // fast enough to follow, slow enough to read
     }
+
+    void paint(juce::Graphics& g) override;
+    void mouseDown(const juce::MouseEvent&) override { meter.reset(); }
+
+private:
+    DSPLoadMeter& meter;
+    juce::String text;
+    juce::Colour colour;
+
+    // Only repaints when the readout has actually changed
+    void timerCallback() override;
 };
 
 
@@ -99,11 +295,19 @@ public:
     //==============================================================================
     void paint (juce::Graphics&) override;
     void resized() override;
+
+    // Everything is laid out at this size inside content, which is then scaled to fit
+    static constexpr int designWidth = 400;
+    static constexpr int designHeight = 400;
+
+    juce::Component content;
     
     juce::Label cronchAmountLabel;
     juce::Label absoluteOffsetLabel;
     juce::Label dryLevelLabel;
     juce::Label octaveLevelLabel;
+    juce::Label octave2LevelLabel;
+    juce::Label octave3LevelLabel;
     
     juce::Slider cronchAmountSlider;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> cronchAmountAttachment;
@@ -115,10 +319,25 @@ public:
     juce::Slider octaveLevelSlider;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> dryLevelAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> octaveLevelAttachment;
+
+    juce::Slider octave2LevelSlider;
+    juce::Slider octave3LevelSlider;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> octave2LevelAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> octave3LevelAttachment;
     
     juce::Slider ochoLPFSlider;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> ochoLPFAttachment;
     juce::Label ochoLPFLabel;
+
+    juce::ComboBox ochoSlopeBox;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> ochoSlopeAttachment;
+
+    juce::Slider ochoHPFSlider;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> ochoHPFAttachment;
+    juce::Label ochoHPFLabel;
+
+    juce::ToggleButton ochoHPFToggle;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> ochoHPFToggleAttachment;
     
     juce::ToggleButton absolutionToggle;
     std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> absolutionToggleAttachment;
@@ -127,12 +346,30 @@ public:
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> absolutionThresholdAttachment;
 
     juce::Label absolutionThresholdLabel;
+
+    juce::ComboBox oversamplingBox;
+    juce::ComboBox antialiasingBox;
+    juce::ComboBox cronchQualityBox;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> oversamplingAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> antialiasingAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> cronchQualityAttachment;
+    juce::Label oversamplingLabel;
+    juce::Label antialiasingLabel;
+    juce::Label cronchQualityLabel;
     
     juce::Label titleLabel;
     
     class CRTOscillationOverlay : public juce::Component
     {
     public:
+        CRTOscillationOverlay()
+        {
+            // The scanlines are drawn once per size into a cached image, so repaints
+            // underneath (the graph, the meters) only blit the overlay's dirty area
+            setBufferedToImage(true);
+            setInterceptsMouseClicks(false, false); // Let clicks pass through
+        }
+
         void paint(juce::Graphics& g) override
         {
             int barHeight = 1;
@@ -151,6 +388,8 @@ public:
     
     GraphComponent absoluteGraph;
 
+    LoadMeterDisplay loadMeterDisplay;
+
 private:
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
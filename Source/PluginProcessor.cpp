@@ -8,6 +8,8 @@
 
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "RealtimeSafety.h"
+#include "PresetState.h"
 
 //==============================================================================
 INTRUSIONAudioProcessor::INTRUSIONAudioProcessor()
@@ -24,16 +26,50 @@ INTRUSIONAudioProcessor::INTRUSIONAudioProcessor()
             std::make_unique<juce::AudioParameterFloat>("absoluteOffset", "DC Offset", -1.0f, 1.0f, 0.0f),
             std::make_unique<juce::AudioParameterFloat>("dryLevel", "Dry Level", 0.0f, 1.0f, 1.0f),
             std::make_unique<juce::AudioParameterFloat>("octaveLevel", "Octave Level", 0.0f, 1.0f, 1.0f),
+            std::make_unique<juce::AudioParameterFloat>("octave2Level", "-2 Octave Level", 0.0f, 1.0f, 0.0f),
+            std::make_unique<juce::AudioParameterFloat>("octave3Level", "-3 Octave Level", 0.0f, 1.0f, 0.0f),
             std::make_unique<juce::AudioParameterFloat>("ochoLPFCutoff", "Ocho LPF Cutoff", 50.0f, 8000.0f, 1000.0f),
+            std::make_unique<juce::AudioParameterChoice>("ochoSlope", "Ocho LPF Slope", juce::StringArray { "12 dB/oct", "24 dB/oct", "36 dB/oct", "48 dB/oct" }, 0),
+            std::make_unique<juce::AudioParameterBool>("ochoHPFOn", "Ocho HPF On", false),
+            std::make_unique<juce::AudioParameterFloat>("ochoHPFCutoff", "Ocho HPF Cutoff", 20.0f, 2000.0f, 80.0f),
             std::make_unique<juce::AudioParameterBool>("absolutionOn", "ABSOLUTION On", false),
-            std::make_unique<juce::AudioParameterFloat>("absolutionThreshold", "ABSOLUTION Threshold", 0.0f, 1.0f, 0.5f)
+            std::make_unique<juce::AudioParameterFloat>("absolutionThreshold", "ABSOLUTION Threshold", 0.0f, 1.0f, 0.5f),
+            std::make_unique<juce::AudioParameterChoice>("cronchQuality", "CRONCH Quality", juce::StringArray { "Reference", "Fast", "Table" }, 0),
+            std::make_unique<juce::AudioParameterChoice>("oversampling", "Oversampling", juce::StringArray { "Off", "2x", "4x", "8x" }, 0),
+            std::make_unique<juce::AudioParameterChoice>("antialiasing", "Anti-aliasing", juce::StringArray { "Off", "ADAA 1st Order", "ADAA 2nd Order" }, 0)
         })
 #endif
 {
+    parameterPointers.cronchAmount = parameters.getRawParameterValue("cronchAmount");
+    parameterPointers.dcOffset = parameters.getRawParameterValue("absoluteOffset");
+    parameterPointers.dryLevel = parameters.getRawParameterValue("dryLevel");
+    parameterPointers.octaveLevel = parameters.getRawParameterValue("octaveLevel");
+    parameterPointers.octave2Level = parameters.getRawParameterValue("octave2Level");
+    parameterPointers.octave3Level = parameters.getRawParameterValue("octave3Level");
+    parameterPointers.ochoLPFCutoff = parameters.getRawParameterValue("ochoLPFCutoff");
+    parameterPointers.ochoSlope = parameters.getRawParameterValue("ochoSlope");
+    parameterPointers.ochoHPFOn = parameters.getRawParameterValue("ochoHPFOn");
+    parameterPointers.ochoHPFCutoff = parameters.getRawParameterValue("ochoHPFCutoff");
+    parameterPointers.absolutionOn = parameters.getRawParameterValue("absolutionOn");
+    parameterPointers.absolutionThreshold = parameters.getRawParameterValue("absolutionThreshold");
+    parameterPointers.cronchQuality = parameters.getRawParameterValue("cronchQuality");
+    parameterPointers.oversampling = parameters.getRawParameterValue("oversampling");
+    parameterPointers.antialiasing = parameters.getRawParameterValue("antialiasing");
+
+    startTimerHz(20);
 }
 
 INTRUSIONAudioProcessor::~INTRUSIONAudioProcessor()
 {
+    stopTimer();
+}
+
+void INTRUSIONAudioProcessor::timerCallback()
+{
+    const auto latency = engine.getLatencySamples();
+
+    if (latency != getLatencySamples())
+        setLatencySamples(latency);
 }
 
 //==============================================================================
@@ -71,7 +107,20 @@ bool INTRUSIONAudioProcessor::isMidiEffect() const
 
 double INTRUSIONAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    // Reported for the slowest-ringing filter settings, so that it doesn't
+    // change under the host while the parameters move
+    ParameterSnapshot slowest;
+    slowest.ochoLPFCutoff = parameters.getParameterRange("ochoLPFCutoff").start;
+    slowest.ochoSlope = OchoCascade<double>::maxLowPassSections - 1;
+    slowest.ochoHPFOn = true;
+    slowest.ochoHPFCutoff = parameters.getParameterRange("ochoHPFCutoff").start;
+
+    auto tail = IntrusionEngine::getTailLengthSeconds(slowest);
+
+    if (getSampleRate() > 0.0)
+        tail += getLatencySamples() / getSampleRate();
+
+    return tail;
 }
 
 int INTRUSIONAudioProcessor::getNumPrograms()
@@ -104,15 +153,33 @@ void INTRUSIONAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBl
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
     
-    lastInputStates.resize(getTotalNumInputChannels(), 0.0f);
-    flipFlopStates.resize(getTotalNumInputChannels(), 1.0f);
-    
-    ochoFilters.resize(getTotalNumInputChannels());
-    for (auto& filter : ochoFilters)
-    {
-        filter.reset();
-        filter.coefficients = juce::dsp::IIR::Coefficients<float>::makeLowPass(sampleRate, 1000.0f);
-    }
+    // The host picks the precision before preparing, so only one chain needs setting up
+    engine.prepare(sampleRate, samplesPerBlock, getTotalNumInputChannels(), isUsingDoublePrecision(), getParameterSnapshot());
+    loadMeter.prepare(sampleRate);
+    scopeFeed.prepare(sampleRate, samplesPerBlock);
+    spectrumAnalyser.prepare(sampleRate);
+    setLatencySamples(engine.getLatencySamples());
+}
+
+INTRUSIONAudioProcessor::ParameterSnapshot INTRUSIONAudioProcessor::getParameterSnapshot() const noexcept
+{
+    ParameterSnapshot snapshot;
+    snapshot.cronchAmount = parameterPointers.cronchAmount->load();
+    snapshot.dcOffset = parameterPointers.dcOffset->load();
+    snapshot.dryLevel = parameterPointers.dryLevel->load();
+    snapshot.octaveLevel = parameterPointers.octaveLevel->load();
+    snapshot.octave2Level = parameterPointers.octave2Level->load();
+    snapshot.octave3Level = parameterPointers.octave3Level->load();
+    snapshot.ochoLPFCutoff = parameterPointers.ochoLPFCutoff->load();
+    snapshot.ochoSlope = juce::roundToInt(parameterPointers.ochoSlope->load());
+    snapshot.ochoHPFOn = parameterPointers.ochoHPFOn->load() > 0.5f;
+    snapshot.ochoHPFCutoff = parameterPointers.ochoHPFCutoff->load();
+    snapshot.absolutionOn = parameterPointers.absolutionOn->load() > 0.5f;
+    snapshot.absolutionThreshold = parameterPointers.absolutionThreshold->load();
+    snapshot.cronchAccuracy = (CronchAccuracy) juce::roundToInt(parameterPointers.cronchQuality->load());
+    snapshot.oversampling = juce::roundToInt(parameterPointers.oversampling->load());
+    snapshot.antialiasing = (ShaperAntialiasing) juce::roundToInt(parameterPointers.antialiasing->load());
+    return snapshot;
 }
 
 void INTRUSIONAudioProcessor::releaseResources()
@@ -128,12 +195,13 @@ bool INTRUSIONAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts
     juce::ignoreUnused (layouts);
     return true;
   #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Every channel gets its own lane in the kernel and nothing mixes across
+    // channels, so any layout works: mono, stereo, 5.1, 7.1.4, ambisonics...
+    // The default stays stereo for hosts, such as certain GarageBand versions,
+    // that only load plugins supporting stereo bus layouts.
+    const auto& output = layouts.getMainOutputChannelSet();
+
+    if (output.isDisabled() || output.size() > IntrusionEngine::maxChannels)
         return false;
 
     // This checks if the input layout matches the output layout
@@ -147,71 +215,43 @@ bool INTRUSIONAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts
 }
 #endif
 
-inline float applyCronchToSample(float x, float amount, float dcOffset)
+void INTRUSIONAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
-    amount = juce::jlimit(0.01f, 100.0f, amount);
-    float shaped = std::copysignf(1.0f - std::expf(-std::abs(x) * amount), x + dcOffset);
-    return juce::jlimit(-1.0f, 1.0f, shaped);
+    juce::ignoreUnused(midiMessages);
+    processSamples(buffer);
 }
 
-inline float applyAbsolutionToSample(float x, float threshold)
+void INTRUSIONAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
 {
-    return std::abs(x) <= threshold ? 0.0f : (x > 0 ? 1.0f : -1.0f);
+    juce::ignoreUnused(midiMessages);
+    processSamples(buffer);
 }
 
-inline float processOcho(float input, float& lastInput, float& flipMultiplier, float dcOffset = 0.0f)
+template <typename SampleType>
+void INTRUSIONAudioProcessor::processSamples(juce::AudioBuffer<SampleType>& buffer)
 {
-    // float adjustedInput = input + dcOffset;
-    float adjustedInput = input; // trying out only applying DC to ABSOLUTE, not octave
+    // With INTRUSION_REALTIME_CHECKS on, anything that could block from here on is reported
+    const RealtimeSafety::ScopedAudioThread audioThread;
+    const DSPLoadMeter::ScopedTimer loadTimer(loadMeter, buffer.getNumSamples());
 
-    // Flip only on positive-going zero crossings
-    if (lastInput < 0.0f && adjustedInput >= 0.0f)
-        flipMultiplier = -flipMultiplier;
-
-    lastInput = adjustedInput;
-
-    return flipMultiplier;
-}
-
-void INTRUSIONAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
-{
-    juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
     
     
-    float lpfCutoff = parameters.getRawParameterValue("ochoLPFCutoff")->load();
-
     // In case we have more outputs than inputs, this code clears any empty outputs
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
 
+    if (totalNumInputChannels > 0)
+        scopeFeed.captureInput(buffer.getReadPointer(0), buffer.getNumSamples());
+
     // MAIN AUDIO PROCESSING
-    float cronchAmount = parameters.getRawParameterValue("cronchAmount")->load();
-    float dcOffset = parameters.getRawParameterValue("absoluteOffset")->load();
-    float dryLevel = parameters.getRawParameterValue("dryLevel")->load();
-    float octaveLevel = parameters.getRawParameterValue("octaveLevel")->load();
-    bool absolutionOn = parameters.getRawParameterValue("absolutionOn")->load() > 0.5f;
-    float absolutionThreshold = parameters.getRawParameterValue("absolutionThreshold")->load();
-
-    for (int channel = 0; channel < totalNumInputChannels; ++channel)
+    engine.process(buffer, totalNumInputChannels, getParameterSnapshot());
+
+    if (totalNumInputChannels > 0)
     {
-        float* channelData = buffer.getWritePointer(channel);
-        ochoFilters[channel].coefficients = juce::dsp::IIR::Coefficients<float>::makeLowPass(getSampleRate(), lpfCutoff);
-
-        for (int sample = 0; sample < buffer.getNumSamples(); ++sample)
-        {
-            float inputSample = channelData[sample];
-
-            // Apply Ocho (octave down flip-flop)
-            float filtered = ochoFilters[channel].processSample(inputSample); // LPF pre-Ocho
-            float ochoSample = filtered * processOcho(filtered, lastInputStates[channel], flipFlopStates[channel], dcOffset);
-            // Apply ABSOLUTE to the Ocho output
-            float mixed = (inputSample * dryLevel) + (ochoSample * octaveLevel);
-            float shaped = applyCronchToSample(mixed, cronchAmount, dcOffset);
-            float output = absolutionOn ? applyAbsolutionToSample(shaped, absolutionThreshold) : shaped;
-            channelData[sample] = output;
-        }
+        scopeFeed.pushOutput(buffer.getReadPointer(0), buffer.getNumSamples());
+        spectrumAnalyser.pushSamples(buffer.getReadPointer(0), buffer.getNumSamples());
     }
 }
 
@@ -229,16 +269,28 @@ juce::AudioProcessorEditor* INTRUSIONAudioProcessor::createEditor()
 //==============================================================================
 void INTRUSIONAudioProcessor::getStateInformation(juce::MemoryBlock& destData)
 {
-    juce::MemoryOutputStream stream(destData, true);
-    parameters.state.writeToStream(stream);
+    // The parameters are the whole state, so only their values are stored
+    auto state = PresetState::write(getParameterSnapshot());
+    destData.append(state.getData(), state.getSize());
 }
 
 void INTRUSIONAudioProcessor::setStateInformation(const void* data, int sizeInBytes)
 {
-    juce::ValueTree tree = juce::ValueTree::readFromData(data, size_t(sizeInBytes));
-    
-    if (tree.isValid())
-        parameters.state = tree;
+    // Also reads the ValueTree states saved by older versions. Anything the state
+    // doesn't mention goes back to its default, as it would for a fresh instance.
+    ParameterSnapshot snapshot;
+
+    if (PresetState::read(data, (size_t) juce::jmax(0, sizeInBytes), snapshot).wasOk())
+        setParameters(snapshot);
+}
+
+void INTRUSIONAudioProcessor::setParameters(const ParameterSnapshot& snapshot)
+{
+    // Parameter values are atomics, so unlike replacing parameters.state, this is
+    // fine from whichever thread the host restores state on
+    for (const auto* id : PresetState::parameterIDs)
+        if (auto* parameter = parameters.getParameter(id))
+            parameter->setValueNotifyingHost(parameter->convertTo0to1(snapshot.getRawValue(id)));
 }
 
 //==============================================================================
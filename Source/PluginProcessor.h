@@ -9,11 +9,16 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "IntrusionEngine.h"
+#include "DSPLoadMeter.h"
+#include "ScopeFeed.h"
+#include "SpectrumAnalyser.h"
 
 //==============================================================================
 /**
 */
-class INTRUSIONAudioProcessor  : public juce::AudioProcessor
+class INTRUSIONAudioProcessor  : public juce::AudioProcessor,
+                                 private juce::Timer
 {
 public:
     //==============================================================================
@@ -29,6 +34,8 @@ public:
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override     { return true; }
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -53,14 +60,63 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
     
-    std::vector<juce::dsp::IIR::Filter<float>> ochoFilters;
-    
     juce::AudioProcessorValueTreeState parameters;
 
+    // Every parameter, read once through the cached atomics
+    using ParameterSnapshot = IntrusionEngine::ParameterSnapshot;
+
+    ParameterSnapshot getParameterSnapshot() const noexcept;
+
+    // Sets every parameter through the host, e.g. to load a preset; safe from any thread
+    void setParameters(const ParameterSnapshot& snapshot);
+
+    // How much of each block's real-time budget processBlock uses; readable from any thread
+    DSPLoadMeter& getLoadMeter() noexcept { return loadMeter; }
+
+    // Decimated frames of the first channel's input and output, for the editor's scope
+    ScopeFeed& getScopeFeed() noexcept { return scopeFeed; }
+
+    // Spectrum of the first output channel, analysed on its own thread while the editor shows it
+    SpectrumAnalyser& getSpectrumAnalyser() noexcept { return spectrumAnalyser; }
+
 private:
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (INTRUSIONAudioProcessor)
-    std::vector<float> lastInputStates;
-    std::vector<float> flipFlopStates;
-    
+
+    // The kernel, oversampling, smoothing and idle bypass; shared with the headless tools
+    IntrusionEngine engine;
+    DSPLoadMeter loadMeter;
+    ScopeFeed scopeFeed;
+    SpectrumAnalyser spectrumAnalyser;
+
+    template <typename SampleType>
+    void processSamples(juce::AudioBuffer<SampleType>& buffer);
+
+    // Reports the new latency once the engine has switched oversampling. Telling
+    // the host takes a lock, and parameter listeners can run on the audio thread
+    // during automation, so this polls from the message thread instead.
+    void timerCallback() override;
+
+    // Looked up by ID once in the constructor instead of on every block
+    struct ParameterPointers
+    {
+        std::atomic<float>* cronchAmount = nullptr;
+        std::atomic<float>* dcOffset = nullptr;
+        std::atomic<float>* dryLevel = nullptr;
+        std::atomic<float>* octaveLevel = nullptr;
+        std::atomic<float>* octave2Level = nullptr;
+        std::atomic<float>* octave3Level = nullptr;
+        std::atomic<float>* ochoLPFCutoff = nullptr;
+        std::atomic<float>* ochoSlope = nullptr;
+        std::atomic<float>* ochoHPFOn = nullptr;
+        std::atomic<float>* ochoHPFCutoff = nullptr;
+        std::atomic<float>* absolutionOn = nullptr;
+        std::atomic<float>* absolutionThreshold = nullptr;
+        std::atomic<float>* cronchQuality = nullptr;
+        std::atomic<float>* oversampling = nullptr;
+        std::atomic<float>* antialiasing = nullptr;
+    };
+
+    ParameterPointers parameterPointers;
+
 };
@@ -0,0 +1,188 @@
+/*
+  ==============================================================================
+
+    PresetLibrary.cpp
+
+  ==============================================================================
+*/
+
+#include "PresetLibrary.h"
+
+//==============================================================================
+juce::Result PresetLibrary::open (const juce::File& file)
+{
+    close();
+
+    auto mapped = std::make_unique<juce::MemoryMappedFile> (file, juce::MemoryMappedFile::readOnly);
+
+    if (mapped->getData() == nullptr)
+        return juce::Result::fail ("can't open preset library " + file.getFullPathName());
+
+    data = static_cast<const juce::uint8*> (mapped->getData());
+    size = mapped->getSize();
+
+    const auto fail = [this, &file]
+    {
+        close();
+        return juce::Result::fail ("not a valid preset library: " + file.getFullPathName());
+    };
+
+    if (size < headerSize || readUint32 (0) != magic)
+        return fail();
+
+    // Only the version this code writes is understood; a newer library needs a newer plugin
+    if (readUint32 (4) != (juce::uint32) currentVersion)
+    {
+        close();
+        return juce::Result::fail ("preset library " + file.getFullPathName() + " is from a newer version");
+    }
+
+    const auto count = (size_t) readUint32 (8);
+
+    if (count > (size - headerSize) / indexEntrySize || count > (size_t) std::numeric_limits<int>::max())
+        return fail();
+
+    // Check every entry once here, so the accessors can trust the index
+    for (size_t i = 0; i < count; ++i)
+    {
+        const auto entry = headerSize + i * indexEntrySize;
+        const auto nameOffset = (size_t) readUint32 (entry), nameSize = (size_t) readUint32 (entry + 4);
+        const auto stateOffset = (size_t) readUint32 (entry + 8), stateSize = (size_t) readUint32 (entry + 12);
+
+        if (nameOffset > size || nameSize > size - nameOffset || stateOffset > size || stateSize > size - stateOffset)
+            return fail();
+    }
+
+    mappedFile = std::move (mapped);
+    numPresets = (int) count;
+    return juce::Result::ok();
+}
+
+void PresetLibrary::close() noexcept
+{
+    mappedFile.reset();
+    data = nullptr;
+    size = 0;
+    numPresets = 0;
+}
+
+//==============================================================================
+juce::String PresetLibrary::getName (int index) const
+{
+    if (! juce::isPositiveAndBelow (index, numPresets))
+        return {};
+
+    const auto entry = getEntry (index);
+    return juce::String::fromUTF8 (reinterpret_cast<const char*> (entry.name), (int) entry.nameSize);
+}
+
+juce::Array<int> PresetLibrary::search (const juce::String& text) const
+{
+    juce::Array<int> results;
+
+    for (int i = 0; i < numPresets; ++i)
+        if (text.isEmpty() || getName (i).containsIgnoreCase (text))
+            results.add (i);
+
+    return results;
+}
+
+int PresetLibrary::indexOf (const juce::String& name) const
+{
+    // The index is sorted by name, so this could bisect, but a linear scan over
+    // mapped names is already far quicker than any preset file could be opened
+    for (int i = 0; i < numPresets; ++i)
+        if (getName (i).equalsIgnoreCase (name))
+            return i;
+
+    return -1;
+}
+
+juce::Result PresetLibrary::loadPreset (int index, ParameterSnapshot& dest) const
+{
+    if (! juce::isPositiveAndBelow (index, numPresets))
+        return juce::Result::fail ("no preset " + juce::String (index));
+
+    const auto entry = getEntry (index);
+    ParameterSnapshot snapshot;
+    const auto result = PresetState::read (entry.state, entry.stateSize, snapshot);
+
+    if (result.wasOk())
+        dest = snapshot;
+
+    return result;
+}
+
+//==============================================================================
+juce::Result PresetLibrary::write (const juce::File& destination, juce::Array<Preset> presets)
+{
+    std::stable_sort (presets.begin(), presets.end(), [] (const Preset& a, const Preset& b)
+    {
+        return a.name.compareIgnoreCase (b.name) < 0;
+    });
+
+    // Lay out the names and states first, so the index can point at them
+    juce::MemoryOutputStream body;
+    std::vector<std::array<juce::uint32, 4>> index;
+    const auto bodyStart = headerSize + (size_t) presets.size() * indexEntrySize;
+
+    for (const auto& preset : presets)
+    {
+        const auto name = preset.name.toUTF8();
+        const auto nameSize = name.sizeInBytes() - 1;
+        const auto nameOffset = bodyStart + body.getDataSize();
+        body.write (name.getAddress(), nameSize);
+
+        const auto stateOffset = bodyStart + body.getDataSize();
+        body << preset.state;
+
+        index.push_back ({ (juce::uint32) nameOffset, (juce::uint32) nameSize,
+                           (juce::uint32) stateOffset, (juce::uint32) preset.state.getSize() });
+    }
+
+    if (bodyStart + body.getDataSize() > std::numeric_limits<juce::uint32>::max())
+        return juce::Result::fail ("too many presets for one library");
+
+    juce::TemporaryFile temp (destination);
+
+    {
+        juce::FileOutputStream out (temp.getFile());
+
+        if (out.failedToOpen())
+            return juce::Result::fail ("can't write " + temp.getFile().getFullPathName());
+
+        out.writeInt ((int) magic);
+        out.writeInt (currentVersion);
+        out.writeInt (presets.size());
+        out.writeInt (0);
+
+        for (const auto& entry : index)
+            for (auto value : entry)
+                out.writeInt ((int) value);
+
+        out << body.getMemoryBlock();
+        out.flush();
+
+        if (out.getStatus().failed())
+            return out.getStatus();
+    }
+
+    if (! temp.overwriteTargetFileWithTemporary())
+        return juce::Result::fail ("can't replace " + destination.getFullPathName());
+
+    return juce::Result::ok();
+}
+
+//==============================================================================
+PresetLibrary::Entry PresetLibrary::getEntry (int index) const noexcept
+{
+    const auto entry = headerSize + (size_t) index * indexEntrySize;
+
+    return { data + readUint32 (entry),      (size_t) readUint32 (entry + 4),
+             data + readUint32 (entry + 8),  (size_t) readUint32 (entry + 12) };
+}
+
+juce::uint32 PresetLibrary::readUint32 (size_t offset) const noexcept
+{
+    return juce::ByteOrder::littleEndianInt (data + offset);
+}
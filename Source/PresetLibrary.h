@@ -0,0 +1,98 @@
+/*
+  ==============================================================================
+
+    PresetLibrary.h
+
+    A whole preset collection in one file, opened as a memory-mapped file, so
+    that thousands of presets can be listed, searched and previewed without
+    opening or parsing each one. Nothing is read until it's asked for, and
+    then only the few bytes concerned.
+
+    Layout, all integers little-endian 32-bit, offsets from the file's start:
+
+        header      'I' 'N' 'P' 'L', version, number of presets, 0
+        index       per preset: name offset, name size, state offset, state size
+        names       UTF-8, unterminated, in index order
+        states      PresetState binary states
+
+    The index is sorted by name, case-insensitively, when the library is written.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PresetState.h"
+
+//==============================================================================
+class PresetLibrary
+{
+public:
+    using ParameterSnapshot = IntrusionEngine::ParameterSnapshot;
+
+    static constexpr const char* fileExtension = ".intrusionpresets";
+
+    struct Preset
+    {
+        juce::String name;
+        juce::MemoryBlock state;    // as written by PresetState::write()
+    };
+
+    //==============================================================================
+    /** Maps file and checks its header and index. Any library already open is
+        closed first, whether or not this succeeds.
+    */
+    juce::Result open (const juce::File& file);
+
+    void close() noexcept;
+
+    bool isOpen() const noexcept                { return data != nullptr; }
+
+    int getNumPresets() const noexcept          { return numPresets; }
+
+    /** The name of the preset at index, in name order. */
+    juce::String getName (int index) const;
+
+    /** The indices of every preset whose name contains text, ignoring case,
+        in name order. An empty text matches everything.
+    */
+    juce::Array<int> search (const juce::String& text) const;
+
+    /** The index of the preset with exactly this name, ignoring case, or -1. */
+    int indexOf (const juce::String& name) const;
+
+    /** Reads a preset's parameters into dest, starting from the defaults, so it
+        can be previewed or applied. Only that preset's bytes are touched.
+    */
+    juce::Result loadPreset (int index, ParameterSnapshot& dest) const;
+
+    //==============================================================================
+    /** Writes a library holding presets, replacing destination only once the
+        whole file has been written.
+    */
+    static juce::Result write (const juce::File& destination, juce::Array<Preset> presets);
+
+private:
+    static constexpr juce::uint32 magic = 0x4c504e49;  // 'I' 'N' 'P' 'L'
+    static constexpr int currentVersion = 1;
+    static constexpr size_t headerSize = 16, indexEntrySize = 16;
+
+    struct Entry
+    {
+        const juce::uint8* name;
+        size_t nameSize;
+        const juce::uint8* state;
+        size_t stateSize;
+    };
+
+    std::unique_ptr<juce::MemoryMappedFile> mappedFile;
+    const juce::uint8* data = nullptr;
+    size_t size = 0;
+    int numPresets = 0;
+
+    Entry getEntry (int index) const noexcept;
+    juce::uint32 readUint32 (size_t offset) const noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PresetLibrary)
+};
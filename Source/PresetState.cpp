@@ -0,0 +1,115 @@
+/*
+  ==============================================================================
+
+    PresetState.cpp
+
+  ==============================================================================
+*/
+
+#include "PresetState.h"
+
+//==============================================================================
+juce::MemoryBlock PresetState::write (const ParameterSnapshot& snapshot)
+{
+    juce::MemoryBlock block;
+    juce::MemoryOutputStream stream (block, false);
+
+    // Little-endian throughout, whatever the machine
+    stream.writeInt ((int) magic);
+    stream.writeByte ((char) currentVersion);
+    stream.writeByte ((char) numParameters);
+
+    for (const auto* id : parameterIDs)
+        stream.writeFloat (snapshot.getRawValue (id));
+
+    stream.flush();
+    return block;
+}
+
+juce::Result PresetState::read (const void* data, size_t size, ParameterSnapshot& dest)
+{
+    if (data == nullptr || size == 0)
+        return juce::Result::fail ("empty state");
+
+    if (isBinary (data, size))
+        return readBinary (static_cast<const juce::uint8*> (data), size, dest);
+
+    return readValueTree (data, size, dest);
+}
+
+bool PresetState::isBinary (const void* data, size_t size) noexcept
+{
+    return data != nullptr && size >= (size_t) headerSize && juce::ByteOrder::littleEndianInt (data) == magic;
+}
+
+//==============================================================================
+juce::Result PresetState::readBinary (const juce::uint8* data, size_t size, ParameterSnapshot& dest)
+{
+    const int version = data[4];
+    const int numValues = data[5];
+
+    if (version == 0 || size < (size_t) (headerSize + numValues * 4))
+        return juce::Result::fail ("truncated or corrupt state");
+
+    // A newer version only appends, so its first values still mean what they mean here
+    ParameterSnapshot snapshot = dest;
+
+    for (int i = 0; i < juce::jmin (numValues, numParameters); ++i)
+    {
+        const auto bits = juce::ByteOrder::littleEndianInt (data + headerSize + i * 4);
+        float value;
+        std::memcpy (&value, &bits, sizeof (value));
+
+        if (std::isfinite (value))
+            snapshot.setRawValue (parameterIDs[(size_t) i], value);
+    }
+
+    dest = snapshot;
+    return juce::Result::ok();
+}
+
+juce::Result PresetState::readValueTree (const void* data, size_t size, ParameterSnapshot& dest)
+{
+    // Sessions saved before the binary format hold a ValueTree stream; presets
+    // from the render tool may also be the same tree as XML. Telling them apart
+    // only needs the first byte after any byte order mark and whitespace, so a
+    // String is only made of the data when it's XML.
+    const auto* bytes = static_cast<const char*> (data);
+    size_t start = 0;
+
+    if (size >= 3 && std::memcmp (bytes, "\xEF\xBB\xBF", 3) == 0)
+        start = 3;
+
+    while (start < size && juce::CharacterFunctions::isWhitespace (bytes[start]))
+        ++start;
+
+    juce::ValueTree state;
+
+    if (start < size && bytes[start] == '<')
+    {
+        if (auto xml = juce::parseXML (juce::String::createStringFromData (data, (int) size)))
+            state = juce::ValueTree::fromXml (*xml);
+    }
+    else
+    {
+        state = juce::ValueTree::readFromData (data, size);
+    }
+
+    // The parameter tree's type, so that other ValueTrees and XML files aren't
+    // taken for presets that happen to set nothing
+    if (! state.isValid() || ! state.hasType ("Parameters"))
+        return juce::Result::fail ("not an INTRUSION state");
+
+    ParameterSnapshot snapshot = dest;
+
+    for (const auto& child : state)
+    {
+        const auto value = (float) child["value"];
+
+        if (child.hasType ("PARAM") && std::isfinite (value))
+            snapshot.setRawValue (child["id"].toString(), value);
+    }
+
+    dest = snapshot;
+    return juce::Result::ok();
+}
@@ -0,0 +1,67 @@
+/*
+  ==============================================================================
+
+    PresetState.h
+
+    The plugin's state in a compact, versioned binary form: a short header and
+    one 32-bit float per parameter, in a fixed order. A session's state is 66
+    bytes instead of a few hundred bytes of ValueTree, and reading it back is a
+    handful of loads rather than a tree or XML parse.
+
+    The ValueTree streams and XML presets written before this format existed
+    are still read, as are binary states from newer versions, which only ever
+    append parameters.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "IntrusionEngine.h"
+
+//==============================================================================
+struct PresetState
+{
+    using ParameterSnapshot = IntrusionEngine::ParameterSnapshot;
+
+    /** The binary format's parameter order. New parameters may only be appended
+        (with a new version), never reordered or removed, so any version can
+        read the values it knows about from any other.
+    */
+    static constexpr std::array<const char*, 15> parameterIDs
+    {
+        "cronchAmount", "absoluteOffset", "dryLevel", "octaveLevel", "octave2Level", "octave3Level",
+        "ochoLPFCutoff", "ochoSlope", "ochoHPFOn", "ochoHPFCutoff", "absolutionOn", "absolutionThreshold",
+        "cronchQuality", "oversampling", "antialiasing"
+    };
+
+    static constexpr int numParameters = (int) parameterIDs.size();
+
+    // Version 0 is the old ValueTree/XML state; the binary format starts at 1
+    static constexpr int currentVersion = 1;
+
+    // 'I' 'N' 'S' 'T', followed by a version byte and a value count byte
+    static constexpr juce::uint32 magic = 0x54534e49;
+    static constexpr int headerSize = 6;
+
+    // For a state saved on its own as a file
+    static constexpr const char* fileExtension = ".intrusionpreset";
+
+    //==============================================================================
+    /** Writes snapshot in the current version. */
+    static juce::MemoryBlock write (const ParameterSnapshot& snapshot);
+
+    /** Reads a state of any version, binary or not, into dest. Parameters the
+        state doesn't mention are left as they are in dest, so start from a
+        default snapshot to load a preset. Fails on data that is neither.
+    */
+    static juce::Result read (const void* data, size_t size, ParameterSnapshot& dest);
+
+    /** True if data starts with a binary state header. */
+    static bool isBinary (const void* data, size_t size) noexcept;
+
+private:
+    static juce::Result readBinary (const juce::uint8* data, size_t size, ParameterSnapshot& dest);
+    static juce::Result readValueTree (const void* data, size_t size, ParameterSnapshot& dest);
+};
@@ -0,0 +1,301 @@
+/*
+  ==============================================================================
+
+    RealtimeSafety.cpp
+
+  ==============================================================================
+*/
+
+#include "RealtimeSafety.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#if INTRUSION_REALTIME_CHECKS && defined (__linux__)
+ #include <cstdarg>
+ #include <cstddef>
+ #include <dlfcn.h>
+#endif
+
+namespace
+{
+    // Both are trivially initialised, so reading them never needs a guard (which
+    // could itself take a lock) and they're usable before static construction
+    thread_local int audioThreadDepth = 0;
+    thread_local int locksAllowedDepth = 0;
+    thread_local bool reporting = false;
+
+    std::atomic<int> numViolations { 0 };
+    std::atomic<RealtimeSafety::Mode> mode { RealtimeSafety::Mode::log };
+
+    const char* getDescription (RealtimeSafety::Violation violation) noexcept
+    {
+        switch (violation)
+        {
+            case RealtimeSafety::Violation::allocation:     return "allocation";
+            case RealtimeSafety::Violation::deallocation:   return "deallocation";
+            case RealtimeSafety::Violation::lock:           return "lock";
+            case RealtimeSafety::Violation::systemCall:     return "system call";
+        }
+
+        return "";
+    }
+}
+
+//==============================================================================
+#if INTRUSION_REALTIME_CHECKS
+RealtimeSafety::ScopedAudioThread::ScopedAudioThread() noexcept    { ++audioThreadDepth; }
+RealtimeSafety::ScopedAudioThread::~ScopedAudioThread() noexcept   { --audioThreadDepth; }
+RealtimeSafety::ScopedLocksAllowed::ScopedLocksAllowed() noexcept   { ++locksAllowedDepth; }
+RealtimeSafety::ScopedLocksAllowed::~ScopedLocksAllowed() noexcept  { --locksAllowedDepth; }
+#endif
+
+void RealtimeSafety::setMode (Mode newMode) noexcept    { mode = newMode; }
+bool RealtimeSafety::isAudioThread() noexcept           { return audioThreadDepth > 0; }
+int RealtimeSafety::getNumViolations() noexcept         { return numViolations; }
+void RealtimeSafety::resetViolations() noexcept         { numViolations = 0; }
+
+void RealtimeSafety::report (Violation violation, const char* function) noexcept
+{
+    // Printing can itself allocate or write, which mustn't be reported again
+    if (audioThreadDepth == 0 || reporting || (violation == Violation::lock && locksAllowedDepth > 0))
+        return;
+
+    reporting = true;
+    ++numViolations;
+
+    std::fprintf (stderr, "Realtime violation on the audio thread: %s in %s\n", getDescription (violation), function);
+
+    if (mode == Mode::trap)
+        std::abort();
+
+    reporting = false;
+}
+
+//==============================================================================
+#if INTRUSION_REALTIME_CHECKS
+
+#if defined (__linux__) && defined (__GLIBC__)
+ #define INTRUSION_INTERPOSE_MALLOC 1
+
+ // glibc's own allocator entry points. Forwarding to these rather than through
+ // dlsym avoids dlsym's calloc coming straight back into the interposers.
+ extern "C" void* __libc_malloc (std::size_t);
+ extern "C" void* __libc_calloc (std::size_t, std::size_t);
+ extern "C" void* __libc_realloc (void*, std::size_t);
+ extern "C" void* __libc_memalign (std::size_t, std::size_t);
+ extern "C" void __libc_free (void*);
+#else
+ #define INTRUSION_INTERPOSE_MALLOC 0
+#endif
+
+namespace
+{
+    // operator new and delete report once themselves, so they go around the
+    // malloc interposers rather than being reported a second time
+    void* allocateUnreported (std::size_t size) noexcept
+    {
+       #if INTRUSION_INTERPOSE_MALLOC
+        return __libc_malloc (size);
+       #else
+        return std::malloc (size);
+       #endif
+    }
+
+    void freeUnreported (void* p) noexcept
+    {
+       #if INTRUSION_INTERPOSE_MALLOC
+        __libc_free (p);
+       #else
+        std::free (p);
+       #endif
+    }
+}
+
+// Aligned new and delete are left alone, as they can't portably be forwarded;
+// on Linux they end up in the aligned_alloc and free interposers below anyway
+void* operator new (std::size_t size)
+{
+    RealtimeSafety::report (RealtimeSafety::Violation::allocation, "operator new");
+
+    if (auto* p = allocateUnreported (size == 0 ? 1 : size))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void* operator new (std::size_t size, const std::nothrow_t&) noexcept
+{
+    RealtimeSafety::report (RealtimeSafety::Violation::allocation, "operator new");
+    return allocateUnreported (size == 0 ? 1 : size);
+}
+
+void* operator new[] (std::size_t size)                             { return operator new (size); }
+void* operator new[] (std::size_t size, const std::nothrow_t& t) noexcept  { return operator new (size, t); }
+
+void operator delete (void* p) noexcept
+{
+    if (p != nullptr)
+        RealtimeSafety::report (RealtimeSafety::Violation::deallocation, "operator delete");
+
+    freeUnreported (p);
+}
+
+void operator delete (void* p, const std::nothrow_t&) noexcept      { operator delete (p); }
+void operator delete (void* p, std::size_t) noexcept                { operator delete (p); }
+void operator delete[] (void* p) noexcept                           { operator delete (p); }
+void operator delete[] (void* p, const std::nothrow_t&) noexcept    { operator delete (p); }
+void operator delete[] (void* p, std::size_t) noexcept              { operator delete (p); }
+
+//==============================================================================
+#if INTRUSION_INTERPOSE_MALLOC
+
+// JUCE's HeapBlock, behind AudioBuffer, Array and MemoryBlock, allocates with
+// malloc and realloc directly, so these matter as much as operator new.
+// The exception specifications match glibc's declarations.
+extern "C" void* malloc (std::size_t size) noexcept
+{
+    RealtimeSafety::report (RealtimeSafety::Violation::allocation, "malloc");
+    return __libc_malloc (size);
+}
+
+extern "C" void* calloc (std::size_t count, std::size_t size) noexcept
+{
+    RealtimeSafety::report (RealtimeSafety::Violation::allocation, "calloc");
+    return __libc_calloc (count, size);
+}
+
+extern "C" void* realloc (void* p, std::size_t size) noexcept
+{
+    RealtimeSafety::report (RealtimeSafety::Violation::allocation, "realloc");
+    return __libc_realloc (p, size);
+}
+
+extern "C" void free (void* p) noexcept
+{
+    if (p != nullptr)
+        RealtimeSafety::report (RealtimeSafety::Violation::deallocation, "free");
+
+    __libc_free (p);
+}
+
+extern "C" int posix_memalign (void** result, std::size_t alignment, std::size_t size) noexcept
+{
+    RealtimeSafety::report (RealtimeSafety::Violation::allocation, "posix_memalign");
+
+    if (alignment < sizeof (void*) || (alignment & (alignment - 1)) != 0)
+        return 22;  // EINVAL
+
+    auto* p = __libc_memalign (alignment, size);
+
+    if (p == nullptr)
+        return 12;  // ENOMEM
+
+    *result = p;
+    return 0;
+}
+
+extern "C" void* aligned_alloc (std::size_t alignment, std::size_t size) noexcept
+{
+    RealtimeSafety::report (RealtimeSafety::Violation::allocation, "aligned_alloc");
+    return __libc_memalign (alignment, size);
+}
+
+#endif // INTRUSION_INTERPOSE_MALLOC
+
+//==============================================================================
+#if defined (__linux__)
+
+// Each interposer reports, then forwards to the next definition of the same
+// symbol, normally libc's. The forwarding pointers are plain zero-initialised
+// globals rather than function statics, as a static's init guard can take a
+// lock and end up back here. Parameter types are only spelled out as far as
+// the calling convention needs; no libc header declaring these is included.
+#define INTRUSION_INTERPOSE(violation, returnType, name, params, args) \
+    static returnType (*next_##name) params = nullptr; \
+    \
+    extern "C" returnType name params \
+    { \
+        RealtimeSafety::report (RealtimeSafety::Violation::violation, #name); \
+        \
+        if (next_##name == nullptr) \
+            next_##name = reinterpret_cast<returnType (*) params> (dlsym (RTLD_NEXT, #name)); \
+        \
+        return next_##name args; \
+    }
+
+INTRUSION_INTERPOSE (lock, int, pthread_mutex_lock,      (void* m), (m))
+INTRUSION_INTERPOSE (lock, int, pthread_rwlock_rdlock,   (void* l), (l))
+INTRUSION_INTERPOSE (lock, int, pthread_rwlock_wrlock,   (void* l), (l))
+INTRUSION_INTERPOSE (lock, int, pthread_cond_wait,       (void* c, void* m), (c, m))
+INTRUSION_INTERPOSE (lock, int, pthread_cond_timedwait,  (void* c, void* m, const void* t), (c, m, t))
+INTRUSION_INTERPOSE (lock, int, sem_wait,                (void* s), (s))
+
+INTRUSION_INTERPOSE (systemCall, long, read,             (int fd, void* data, std::size_t size), (fd, data, size))
+INTRUSION_INTERPOSE (systemCall, long, write,            (int fd, const void* data, std::size_t size), (fd, data, size))
+INTRUSION_INTERPOSE (systemCall, int,  close,            (int fd), (fd))
+INTRUSION_INTERPOSE (systemCall, int,  usleep,           (unsigned int microseconds), (microseconds))
+INTRUSION_INTERPOSE (systemCall, int,  nanosleep,        (const void* duration, void* remaining), (duration, remaining))
+INTRUSION_INTERPOSE (systemCall, int,  sched_yield,      (), ())
+INTRUSION_INTERPOSE (systemCall, void*, mmap,            (void* address, std::size_t size, int protection, int flags, int fd, long offset),
+                                                         (address, size, protection, flags, fd, offset))
+INTRUSION_INTERPOSE (systemCall, int,  munmap,           (void* address, std::size_t size), (address, size))
+
+#undef INTRUSION_INTERPOSE
+
+// open() and openat() are variadic, and the mode is only passed when the flags
+// create a file, so it mustn't be read otherwise. These are O_CREAT and the bit
+// unique to O_TMPFILE, the same on x86 and ARM; <fcntl.h> can't be included here.
+static bool needsFileMode (int flags) noexcept
+{
+    return (flags & 0100) != 0 || (flags & 020000000) != 0;
+}
+
+static int (*next_open) (const char*, int, ...) = nullptr;
+static int (*next_openat) (int, const char*, int, ...) = nullptr;
+
+extern "C" int open (const char* path, int flags, ...)
+{
+    RealtimeSafety::report (RealtimeSafety::Violation::systemCall, "open");
+
+    unsigned int fileMode = 0;
+
+    if (needsFileMode (flags))
+    {
+        va_list args;
+        va_start (args, flags);
+        fileMode = va_arg (args, unsigned int);
+        va_end (args);
+    }
+
+    if (next_open == nullptr)
+        next_open = reinterpret_cast<int (*) (const char*, int, ...)> (dlsym (RTLD_NEXT, "open"));
+
+    return next_open (path, flags, fileMode);
+}
+
+// What glibc and libstdc++ use for most file opens
+extern "C" int openat (int directory, const char* path, int flags, ...)
+{
+    RealtimeSafety::report (RealtimeSafety::Violation::systemCall, "openat");
+
+    unsigned int fileMode = 0;
+
+    if (needsFileMode (flags))
+    {
+        va_list args;
+        va_start (args, flags);
+        fileMode = va_arg (args, unsigned int);
+        va_end (args);
+    }
+
+    if (next_openat == nullptr)
+        next_openat = reinterpret_cast<int (*) (int, const char*, int, ...)> (dlsym (RTLD_NEXT, "openat"));
+
+    return next_openat (directory, path, flags, fileMode);
+}
+
+#endif // __linux__
+#endif // INTRUSION_REALTIME_CHECKS
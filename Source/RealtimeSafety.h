@@ -0,0 +1,97 @@
+/*
+  ==============================================================================
+
+    RealtimeSafety.h
+
+    A debug/test mode that catches calls which can block the audio thread:
+    heap allocation through operator new/delete or malloc and friends, mutex
+    locks, and common system calls such as file I/O, sleeping and memory
+    mapping.
+
+    processBlock marks the audio thread for its duration. With
+    INTRUSION_REALTIME_CHECKS=1, operator new and delete are replaced, and on
+    Linux the allocator (with glibc), lock and system call entry points are
+    interposed, so any of them reached from inside processBlock is reported. With the flag off (as in the
+    plugin builds) all of this compiles to nothing.
+
+    Interposing only works in an executable, since a plugin's own calls
+    resolve to the host's symbols first, so the checks are meant for test
+    drivers such as Tools/RealtimeCheck rather than for plugin builds.
+
+    Unlike the rest of Source/, this doesn't include JuceHeader.h. The
+    interposers define libc functions under their own names, and the system
+    headers JUCE pulls in would declare them with conflicting signatures.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#ifndef INTRUSION_REALTIME_CHECKS
+ #define INTRUSION_REALTIME_CHECKS 0
+#endif
+
+//==============================================================================
+struct RealtimeSafety
+{
+    enum class Violation
+    {
+        allocation,
+        deallocation,
+        lock,
+        systemCall
+    };
+
+    enum class Mode
+    {
+        log,    // print each violation to stderr and carry on
+        trap    // abort at the first one, so a debugger stops on the offending call
+    };
+
+    /** Marks the calling thread as the audio thread while it exists. Nesting is fine. */
+    class ScopedAudioThread
+    {
+    public:
+       #if INTRUSION_REALTIME_CHECKS
+        ScopedAudioThread() noexcept;
+        ~ScopedAudioThread() noexcept;
+       #else
+        ScopedAudioThread() noexcept {}
+       #endif
+
+        ScopedAudioThread (const ScopedAudioThread&) = delete;
+        ScopedAudioThread& operator= (const ScopedAudioThread&) = delete;
+    };
+
+    /** Stops locks on the calling thread being reported while it exists, for
+        code outside the plugin that locks on the audio thread anyway, such as
+        JUCE's parameter listener dispatch when a host automates. Allocations
+        and system calls are still reported.
+    */
+    class ScopedLocksAllowed
+    {
+    public:
+       #if INTRUSION_REALTIME_CHECKS
+        ScopedLocksAllowed() noexcept;
+        ~ScopedLocksAllowed() noexcept;
+       #else
+        ScopedLocksAllowed() noexcept {}
+       #endif
+
+        ScopedLocksAllowed (const ScopedLocksAllowed&) = delete;
+        ScopedLocksAllowed& operator= (const ScopedLocksAllowed&) = delete;
+    };
+
+    static constexpr bool isEnabled() noexcept    { return INTRUSION_REALTIME_CHECKS != 0; }
+
+    static void setMode (Mode newMode) noexcept;
+
+    /** True while the calling thread is inside a ScopedAudioThread. */
+    static bool isAudioThread() noexcept;
+
+    /** Counts and reports a violation if the calling thread is the audio thread. */
+    static void report (Violation violation, const char* function) noexcept;
+
+    static int getNumViolations() noexcept;
+    static void resetViolations() noexcept;
+};
@@ -0,0 +1,171 @@
+/*
+  ==============================================================================
+
+    ScopeFeed.h
+
+    Carries what the plugin actually outputs from the audio thread to the
+    editor's scope and X-Y view, through a wait-free single-producer,
+    single-consumer FIFO (juce::AbstractFifo).
+
+    The output is decimated into min/max frames at a fixed frame rate, so the
+    cost on the audio thread is one vectorised min/max pass over the block and
+    a few stores per frame, whatever the sample rate. The feed only runs while
+    the editor has it switched on; if the reader falls behind, the FIFO fills up
+    and further frames are simply dropped.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/** One decimated slice of the first channel. */
+struct ScopeFrame
+{
+    float outputMin = 0.0f, outputMax = 0.0f;   // envelope over the slice, for the scope
+    float input = 0.0f, output = 0.0f;          // the slice's last sample in and out, for the X-Y view
+};
+
+//==============================================================================
+class ScopeFeed
+{
+public:
+    static constexpr int capacity = 8192;           // about a second of frames
+    static constexpr double targetFrameRate = 8000.0;
+
+    ScopeFeed() : frames ((size_t) capacity) {}
+
+    //==============================================================================
+    /** Sizes the audio thread's scratch space. Call from prepareToPlay. The FIFO
+        itself is never reallocated, as the editor may be reading from it.
+    */
+    void prepare (double sampleRate, int maximumBlockSize)
+    {
+        decimation = juce::jmax (1, juce::roundToInt (sampleRate / targetFrameRate));
+        pending.assign ((size_t) (maximumBlockSize / decimation + 1), {});
+
+        capturing = false;
+        current = {};
+        startNewFrame();
+    }
+
+    /** Switches the feed on or off, as the editor opens and closes. While it's
+        off the audio thread skips it entirely. Switching on throws away any
+        frames left from before, so the editor doesn't draw stale audio. Call
+        from the reader thread.
+    */
+    void setActive (bool shouldBeActive) noexcept
+    {
+        if (shouldBeActive && ! active.load())
+            fifo.finishedRead (fifo.getNumReady());
+
+        active = shouldBeActive;
+    }
+
+    /** Notes the input at each frame boundary. Call on the audio thread with
+        the block as it arrives, before it is processed in place.
+    */
+    template <typename SampleType>
+    void captureInput (const SampleType* input, int numSamples) noexcept
+    {
+        // Latched for the block, so pushOutput goes along with whatever this decided
+        const auto wasCapturing = capturing;
+        capturing = active.load (std::memory_order_relaxed);
+
+        if (! capturing)
+            return;
+
+        // A frame left half-built when the feed was last switched off is abandoned
+        if (! wasCapturing)
+            startNewFrame();
+
+        const int framesEvery = decimation;
+        size_t numCaptured = 0;
+
+        // Straight from one frame boundary to the next, starting where the frame
+        // carried over from the last block ends
+        for (int i = framesEvery - samplesInFrame - 1; i < numSamples && numCaptured < pending.size(); i += framesEvery)
+            pending[numCaptured++].input = (float) input[i];
+    }
+
+    /** Builds frames from the processed block and hands them to the reader.
+        Call on the audio thread after processing, with the same block length.
+    */
+    template <typename SampleType>
+    void pushOutput (const SampleType* output, int numSamples) noexcept
+    {
+        if (! capturing)
+            return;
+
+        const int framesEvery = decimation;
+        size_t numFrames = 0;
+
+        // A frame's worth at a time: the envelope over each span is one vectorised
+        // pass, and only the spans that reach a boundary finish a frame
+        for (int start = 0; start < numSamples;)
+        {
+            const auto spanLength = juce::jmin (numSamples - start, framesEvery - samplesInFrame);
+            const auto range = juce::FloatVectorOperations::findMinAndMax (output + start, spanLength);
+
+            current.outputMin = juce::jmin (current.outputMin, (float) range.getStart());
+            current.outputMax = juce::jmax (current.outputMax, (float) range.getEnd());
+
+            start += spanLength;
+            samplesInFrame += spanLength;
+
+            if (samplesInFrame == framesEvery)
+            {
+                if (numFrames < pending.size())
+                {
+                    auto& frame = pending[numFrames++];
+                    frame.outputMin = current.outputMin;
+                    frame.outputMax = current.outputMax;
+                    frame.output = (float) output[start - 1];
+                }
+
+                startNewFrame();
+            }
+        }
+
+        // Whatever doesn't fit is dropped; the audio thread never waits for the reader
+        const auto scope = fifo.write ((int) numFrames);
+        size_t next = 0;
+        scope.forEach ([&] (int index) { frames[(size_t) index] = pending[next++]; });
+    }
+
+    //==============================================================================
+    /** Moves up to maxFrames of the oldest waiting frames into dest and returns
+        how many. Call from a single reader thread, normally the message thread.
+    */
+    int read (ScopeFrame* dest, int maxFrames) noexcept
+    {
+        const auto scope = fifo.read (juce::jmin (maxFrames, fifo.getNumReady()));
+        int numRead = 0;
+        scope.forEach ([&] (int index) { dest[numRead++] = frames[(size_t) index]; });
+        return numRead;
+    }
+
+    /** The number of samples each frame covers. */
+    int getDecimation() const noexcept      { return decimation; }
+
+private:
+    juce::AbstractFifo fifo { capacity };
+    std::vector<ScopeFrame> frames;
+    std::atomic<int> decimation { 1 };
+    std::atomic<bool> active { false };
+
+    // Audio thread only: the frame being built, carried across blocks
+    std::vector<ScopeFrame> pending;
+    ScopeFrame current;
+    int samplesInFrame = 0;
+    bool capturing = false;
+
+    void startNewFrame() noexcept
+    {
+        samplesInFrame = 0;
+        current.outputMin = std::numeric_limits<float>::max();
+        current.outputMax = std::numeric_limits<float>::lowest();
+    }
+};
@@ -0,0 +1,211 @@
+/*
+  ==============================================================================
+
+    SpectrumAnalyser.h
+
+    A spectrum of the plugin's output, for seeing how much aliasing CRONCH and
+    ABSOLUTION produce at the current settings, or what the octave divider
+    adds, without loading a separate analyser.
+
+    The audio thread only pushes its output samples into a lock-free FIFO, and
+    only while the spectrum is on screen. Windowing, the FFT and the log-spaced
+    binning run on a background thread with everything allocated up front, and
+    the finished spectra reach the editor through a lock-free triple buffer.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+class SpectrumAnalyser : private juce::Thread
+{
+public:
+    static constexpr int fftOrder = 12;
+    static constexpr int fftSize = 1 << fftOrder;          // ~12 Hz resolution at 48 kHz
+    static constexpr int hopSize = fftSize / 2;             // half-overlapped Hann windows
+    static constexpr int numBins = 192;                     // log-spaced, 20 Hz to Nyquist
+    static constexpr float minFrequency = 20.0f;
+    static constexpr float floorDecibels = -120.0f;
+
+    using Spectrum = std::array<float, (size_t) numBins>;  // dB relative to a full-scale sine
+
+    SpectrumAnalyser()
+        : juce::Thread ("INTRUSION spectrum"),
+          fft (fftOrder),
+          window ((size_t) fftSize, juce::dsp::WindowingFunction<float>::hann, false)
+    {
+        for (auto& spectrum : spectra)
+            spectrum.fill (floorDecibels);
+
+        smoothed.fill (floorDecibels);
+    }
+
+    ~SpectrumAnalyser() override
+    {
+        stopThread (1000);
+    }
+
+    //==============================================================================
+    /** Call from prepareToPlay. Nothing is allocated. */
+    void prepare (double newSampleRate) noexcept
+    {
+        sampleRate = newSampleRate;
+    }
+
+    /** Starts or stops the analysis thread, e.g. as the spectrum is shown or
+        hidden. While stopped, the audio thread doesn't even push. Message thread only.
+    */
+    void setActive (bool shouldBeActive)
+    {
+        if (shouldBeActive == isThreadRunning())
+            return;
+
+        if (shouldBeActive)
+        {
+            startThread (juce::Thread::Priority::low);
+            active = true;
+        }
+        else
+        {
+            active = false;
+            stopThread (1000);
+        }
+    }
+
+    /** Audio thread: hands a block of output to the analyser. Whatever doesn't fit
+        in the FIFO is dropped rather than waited for.
+    */
+    template <typename SampleType>
+    void pushSamples (const SampleType* samples, int numSamples) noexcept
+    {
+        if (! active.load (std::memory_order_relaxed))
+            return;
+
+        const auto scope = fifo.write (numSamples);
+        int next = 0;
+        scope.forEach ([&] (int index) { fifoBuffer[(size_t) index] = (float) samples[next++]; });
+    }
+
+    /** Copies the newest spectrum into dest if one has arrived since the last
+        call. Call from one reader thread only.
+    */
+    bool getLatestSpectrum (Spectrum& dest) noexcept
+    {
+        if ((middle.load (std::memory_order_acquire) & freshFlag) == 0)
+            return false;
+
+        front = middle.exchange (front, std::memory_order_acq_rel) & indexMask;
+        dest = spectra[(size_t) front];
+        return true;
+    }
+
+    /** The frequency at the centre of bin i, for drawing. */
+    float getBinFrequency (int bin) const noexcept
+    {
+        const auto nyquist = (float) sampleRate.load() * 0.5f;
+        return minFrequency * std::pow (nyquist / minFrequency, ((float) bin + 0.5f) / (float) numBins);
+    }
+
+    double getSampleRate() const noexcept       { return sampleRate; }
+
+private:
+    static constexpr int fifoSize = fftSize * 8;
+
+    juce::AbstractFifo fifo { fifoSize };
+    std::array<float, (size_t) fifoSize> fifoBuffer {};
+    std::atomic<bool> active { false };
+    std::atomic<double> sampleRate { 44100.0 };
+
+    // Analysis thread only
+    juce::dsp::FFT fft;
+    juce::dsp::WindowingFunction<float> window;
+    std::array<float, (size_t) fftSize> history {};            // the last fftSize samples, oldest first
+    std::array<float, (size_t) fftSize * 2> fftData {};
+    std::array<std::pair<int, int>, (size_t) numBins> binRanges {};   // FFT bins [first, end) behind each output bin
+    Spectrum smoothed;
+    double binnedSampleRate = 0.0;
+
+    // Triple buffer: the analysis thread fills back, then swaps it with middle
+    // and marks it fresh; the reader swaps front with middle when it's fresh
+    static constexpr int indexMask = 3, freshFlag = 4;
+    std::array<Spectrum, 3> spectra;
+    std::atomic<int> middle { 1 };
+    int back = 0, front = 2;
+
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            // half an FFT frame is only ~20 ms, so polling a little faster than that keeps up
+            if (! analyseAvailableSamples())
+                wait (5);
+        }
+    }
+
+    bool analyseAvailableSamples()
+    {
+        if (fifo.getNumReady() < hopSize)
+            return false;
+
+        {
+            // Slide the history along and append the new samples
+            const auto scope = fifo.read (hopSize);
+            std::copy (history.begin() + hopSize, history.end(), history.begin());
+            auto next = (size_t) (fftSize - hopSize);
+            scope.forEach ([&] (int index) { history[next++] = fifoBuffer[(size_t) index]; });
+        }
+
+        if (! juce::exactlyEqual (binnedSampleRate, sampleRate.load()))
+            updateBinRanges();
+
+        std::copy (history.begin(), history.end(), fftData.begin());
+        std::fill (fftData.begin() + fftSize, fftData.end(), 0.0f);
+        window.multiplyWithWindowingTable (fftData.data(), (size_t) fftSize);
+        fft.performFrequencyOnlyForwardTransform (fftData.data(), true);
+
+        // A full-scale sine through a Hann window peaks at fftSize / 4
+        constexpr auto fullScale = (float) fftSize * 0.25f;
+        auto& spectrum = spectra[(size_t) back];
+
+        for (size_t b = 0; b < (size_t) numBins; ++b)
+        {
+            // The loudest FFT bin in range, so narrow alias lines aren't averaged away
+            auto peak = 0.0f;
+
+            for (auto k = binRanges[b].first; k < binRanges[b].second; ++k)
+                peak = juce::jmax (peak, fftData[(size_t) k]);
+
+            const auto decibels = juce::Decibels::gainToDecibels (peak / fullScale, floorDecibels);
+
+            // Instant attack, gentle release, so peaks can be read off
+            smoothed[b] = decibels > smoothed[b] ? decibels : smoothed[b] + 0.3f * (decibels - smoothed[b]);
+            spectrum[b] = smoothed[b];
+        }
+
+        back = middle.exchange (back | freshFlag, std::memory_order_acq_rel) & indexMask;
+        return true;
+    }
+
+    void updateBinRanges() noexcept
+    {
+        binnedSampleRate = sampleRate.load();
+        const auto binWidth = binnedSampleRate / fftSize;
+        const auto nyquist = binnedSampleRate * 0.5;
+
+        auto fftBinAt = [&] (int edge)
+        {
+            const auto frequency = minFrequency * std::pow (nyquist / minFrequency, (double) edge / numBins);
+            return juce::jlimit (1, fftSize / 2, juce::roundToInt (frequency / binWidth));
+        };
+
+        // At the low end several output bins fall within one FFT bin, and share it
+        for (int b = 0; b < numBins; ++b)
+        {
+            const auto first = fftBinAt (b);
+            binRanges[(size_t) b] = { first, juce::jmax (first + 1, fftBinAt (b + 1)) };
+        }
+    }
+};
@@ -0,0 +1,735 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    intrusion-bench: times the plugin's processBlock, the whole engine, and
+    each DSP stage on its own, across block sizes, channel counts, sample
+    rates and parameter states. Results are written as JSON and can be checked
+    against a stored baseline, so every optimisation comes with before and
+    after numbers.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "IntrusionEngine.h"
+#include "PluginProcessor.h"
+
+namespace
+{
+
+using ParameterSnapshot = IntrusionEngine::ParameterSnapshot;
+
+//==============================================================================
+/** A named set of parameters. Automated states move parameters every block,
+    the way a host automation lane would, so the ramping paths are timed too.
+*/
+struct BenchState
+{
+    juce::String name;
+    ParameterSnapshot snapshot;
+    bool automated = false;
+
+    ParameterSnapshot getSnapshotForBlock (int blockIndex) const noexcept
+    {
+        if (! automated)
+            return snapshot;
+
+        // slow enough that most blocks ramp rather than jump
+        const auto phase = (float) blockIndex * 0.05f;
+        auto s = snapshot;
+        s.cronchAmount = 1.0f + 20.0f * (0.5f + 0.5f * std::sin (phase));
+        s.octaveLevel = 0.5f + 0.5f * std::cos (phase * 0.7f);
+        s.ochoLPFCutoff = 300.0f + 1500.0f * (0.5f + 0.5f * std::sin (phase * 0.3f));
+        return s;
+    }
+};
+
+juce::Array<BenchState> makeStates()
+{
+    juce::Array<BenchState> states;
+
+    states.add ({ "default", {} });
+
+    {
+        BenchState full { "full" };
+        full.snapshot.cronchAmount = 20.0f;
+        full.snapshot.octave2Level = 0.7f;
+        full.snapshot.octave3Level = 0.5f;
+        full.snapshot.ochoSlope = 3;
+        full.snapshot.ochoHPFOn = true;
+        full.snapshot.absolutionOn = true;
+        states.add (full);
+    }
+
+    {
+        BenchState fast { "fast" };
+        fast.snapshot.cronchAccuracy = CronchAccuracy::fast;
+        states.add (fast);
+    }
+
+    {
+        BenchState adaa { "adaa" };
+        adaa.snapshot.antialiasing = ShaperAntialiasing::secondOrderADAA;
+        states.add (adaa);
+    }
+
+    {
+        BenchState oversampled { "oversampled4x" };
+        oversampled.snapshot.oversampling = 2;
+        states.add (oversampled);
+    }
+
+    states.add ({ "automated", {}, true });
+    return states;
+}
+
+//==============================================================================
+struct BenchConfig
+{
+    double sampleRate = 48000.0;
+    int numChannels = 2;
+    int blockSize = 512;
+    const BenchState* state = nullptr;
+};
+
+/** One thing being timed. prepare() runs before every timed run and is not
+    counted; processBlock() is called once per block of input.
+*/
+template <typename SampleType>
+struct Stage
+{
+    virtual ~Stage() = default;
+
+    virtual void prepare (const BenchConfig& config) = 0;
+    virtual void processBlock (const SampleType* const* input, SampleType* const* output,
+                               int numChannels, int numSamples, int blockIndex) noexcept = 0;
+};
+
+//==============================================================================
+/** INTRUSIONAudioProcessor::processBlock, as a host calls it: the engine plus
+    reading the parameters, the load meter, and feeding the scope and spectrum.
+    Automated states set the parameters through the host before each block.
+*/
+template <typename SampleType>
+struct ProcessorStage : public Stage<SampleType>
+{
+    void prepare (const BenchConfig& newConfig) override
+    {
+        config = newConfig;
+        buffer.setSize (config.numChannels, config.blockSize);
+
+        processor = std::make_unique<INTRUSIONAudioProcessor>();
+
+        juce::AudioProcessor::BusesLayout layout;
+        layout.inputBuses.add (juce::AudioChannelSet::discreteChannels (config.numChannels));
+        layout.outputBuses.add (juce::AudioChannelSet::discreteChannels (config.numChannels));
+        processor->setBusesLayout (layout);
+
+        processor->setProcessingPrecision (std::is_same_v<SampleType, double> ? juce::AudioProcessor::doublePrecision
+                                                                              : juce::AudioProcessor::singlePrecision);
+        processor->setParameters (config.state->snapshot);
+        processor->prepareToPlay (config.sampleRate, config.blockSize);
+    }
+
+    void processBlock (const SampleType* const* input, SampleType* const* output,
+                       int numChannels, int numSamples, int blockIndex) noexcept override
+    {
+        if (config.state->automated)
+            processor->setParameters (config.state->getSnapshotForBlock (blockIndex));
+
+        for (int c = 0; c < numChannels; ++c)
+            buffer.copyFrom (c, 0, input[c], numSamples);
+
+        processor->processBlock (buffer, midi);
+
+        for (int c = 0; c < numChannels; ++c)
+            output[c][0] = buffer.getSample (c, 0);
+    }
+
+    BenchConfig config;
+    std::unique_ptr<INTRUSIONAudioProcessor> processor;
+    juce::AudioBuffer<SampleType> buffer;
+    juce::MidiBuffer midi;
+};
+
+/** The full chain exactly as the plugin runs it. As the engine works in place,
+    each block is first copied into its buffer, like a host handing over fresh audio.
+*/
+template <typename SampleType>
+struct EngineStage : public Stage<SampleType>
+{
+    void prepare (const BenchConfig& newConfig) override
+    {
+        config = newConfig;
+        buffer.setSize (config.numChannels, config.blockSize);
+        engine.prepare (config.sampleRate, config.blockSize, config.numChannels,
+                        std::is_same_v<SampleType, double>, config.state->snapshot);
+    }
+
+    void processBlock (const SampleType* const* input, SampleType* const* output,
+                       int numChannels, int numSamples, int blockIndex) noexcept override
+    {
+        for (int c = 0; c < numChannels; ++c)
+            buffer.copyFrom (c, 0, input[c], numSamples);
+
+        engine.process (buffer, numChannels, config.state->getSnapshotForBlock (blockIndex));
+
+        for (int c = 0; c < numChannels; ++c)
+            output[c][0] = buffer.getSample (c, 0);
+    }
+
+    BenchConfig config;
+    IntrusionEngine engine;
+    juce::AudioBuffer<SampleType> buffer;
+};
+
+/** Kernel parameters held at the snapshot's values, as the engine would pass them once settled. */
+template <typename SampleType>
+typename IntrusionKernel<SampleType>::Parameters makeKernelParameters (const ParameterSnapshot& s)
+{
+    using Kernel = IntrusionKernel<SampleType>;
+
+    typename Kernel::Parameters p;
+    p.cronchAmount = { (SampleType) juce::jlimit (0.01f, 100.0f, s.cronchAmount) };
+    p.dcOffset = { (SampleType) s.dcOffset };
+    p.dryLevel = { (SampleType) s.dryLevel };
+    p.octaveLevel = { (SampleType) s.octaveLevel };
+    p.octave2Level = { (SampleType) s.octave2Level };
+    p.octave3Level = { (SampleType) s.octave3Level };
+    p.absolutionOn = s.absolutionOn;
+    p.absolutionGate = { Kernel::absolutionArgumentThreshold ((SampleType) s.absolutionThreshold) };
+    p.cronchAccuracy = s.cronchAccuracy;
+    p.antialiasing = s.antialiasing;
+    return p;
+}
+
+/** The vectorised Ocho filter, flip-flop and dry/octave mix: the kernel's
+    half of the chain before the shaper.
+*/
+template <typename SampleType>
+struct KernelOchoStage : public Stage<SampleType>
+{
+    void prepare (const BenchConfig& newConfig) override
+    {
+        config = newConfig;
+        buffer.setSize (config.numChannels, config.blockSize);
+        kernel.prepare (config.numChannels);
+        coefficients.prepare (config.sampleRate, config.state->snapshot.getOchoResponse());
+    }
+
+    void processBlock (const SampleType* const* input, SampleType* const* output,
+                       int numChannels, int numSamples, int blockIndex) noexcept override
+    {
+        for (int c = 0; c < numChannels; ++c)
+            buffer.copyFrom (c, 0, input[c], numSamples);
+
+        const auto snapshot = config.state->getSnapshotForBlock (blockIndex);
+        coefficients.setResponse (snapshot.getOchoResponse());
+        kernel.processOchoAndMix (buffer.getArrayOfWritePointers(), numChannels, numSamples,
+                                  coefficients, makeKernelParameters<SampleType> (snapshot));
+        coefficients.advance (numSamples);
+
+        for (int c = 0; c < numChannels; ++c)
+            output[c][0] = buffer.getSample (c, 0);
+    }
+
+    BenchConfig config;
+    IntrusionKernel<SampleType> kernel;
+    OchoCoefficientEngine<SampleType> coefficients;
+    juce::AudioBuffer<SampleType> buffer;
+};
+
+/** CRONCH and ABSOLUTION as the kernel runs them, at the host rate. */
+template <typename SampleType>
+struct KernelShaperStage : public Stage<SampleType>
+{
+    void prepare (const BenchConfig& newConfig) override
+    {
+        config = newConfig;
+        buffer.setSize (config.numChannels, config.blockSize);
+        kernel.prepare (config.numChannels);
+    }
+
+    void processBlock (const SampleType* const* input, SampleType* const* output,
+                       int numChannels, int numSamples, int blockIndex) noexcept override
+    {
+        for (int c = 0; c < numChannels; ++c)
+            buffer.copyFrom (c, 0, input[c], numSamples);
+
+        auto block = juce::dsp::AudioBlock<SampleType> (buffer).getSubsetChannelBlock (0, (size_t) numChannels)
+                                                                .getSubBlock (0, (size_t) numSamples);
+        kernel.processShaper (block, makeKernelParameters<SampleType> (config.state->getSnapshotForBlock (blockIndex)));
+
+        for (int c = 0; c < numChannels; ++c)
+            output[c][0] = buffer.getSample (c, 0);
+    }
+
+    BenchConfig config;
+    IntrusionKernel<SampleType> kernel;
+    juce::AudioBuffer<SampleType> buffer;
+};
+
+//==============================================================================
+// The scalar reference stages, one channel and one sample at a time. These are
+// what the kernel is checked against, and show what the vectorisation buys.
+
+template <typename SampleType>
+struct ScalarLowPassStage : public Stage<SampleType>
+{
+    void prepare (const BenchConfig& newConfig) override
+    {
+        config = newConfig;
+        cascade = OchoCascade<SampleType>::make (config.sampleRate, config.state->snapshot.getOchoResponse());
+        filters.assign ((size_t) config.numChannels, {});
+    }
+
+    void processBlock (const SampleType* const* input, SampleType* const* output,
+                       int numChannels, int numSamples, int blockIndex) noexcept override
+    {
+        // The sections run must match the cascade built for this block
+        const auto response = config.state->getSnapshotForBlock (blockIndex).getOchoResponse();
+
+        if (config.state->automated)
+            cascade = OchoCascade<SampleType>::make (config.sampleRate, response);
+
+        const auto first = response.highPassOn ? OchoCascade<SampleType>::highPassSlot : OchoCascade<SampleType>::firstLowPassSlot;
+        const auto end = OchoCascade<SampleType>::firstLowPassSlot + response.lowPassSections;
+
+        for (int c = 0; c < numChannels; ++c)
+        {
+            auto& filter = filters[(size_t) c];
+
+            for (int i = 0; i < numSamples; ++i)
+                output[c][i] = filter.processSample (input[c][i], cascade, first, end);
+        }
+    }
+
+    BenchConfig config;
+    OchoCascade<SampleType> cascade;
+    std::vector<OchoFilter<SampleType>> filters;
+};
+
+template <typename SampleType>
+struct ScalarOchoStage : public Stage<SampleType>
+{
+    void prepare (const BenchConfig& config) override
+    {
+        lastInputs.assign ((size_t) config.numChannels, 0);
+        flips.assign ((size_t) config.numChannels, 1);
+    }
+
+    void processBlock (const SampleType* const* input, SampleType* const* output,
+                       int numChannels, int numSamples, int) noexcept override
+    {
+        for (int c = 0; c < numChannels; ++c)
+            for (int i = 0; i < numSamples; ++i)
+                output[c][i] = input[c][i] * processOcho (input[c][i], lastInputs[(size_t) c], flips[(size_t) c]);
+    }
+
+    std::vector<SampleType> lastInputs, flips;
+};
+
+template <typename SampleType>
+struct ScalarCronchStage : public Stage<SampleType>
+{
+    void prepare (const BenchConfig& newConfig) override    { config = newConfig; }
+
+    void processBlock (const SampleType* const* input, SampleType* const* output,
+                       int numChannels, int numSamples, int blockIndex) noexcept override
+    {
+        const auto snapshot = config.state->getSnapshotForBlock (blockIndex);
+        const auto amount = (SampleType) snapshot.cronchAmount, dcOffset = (SampleType) snapshot.dcOffset;
+
+        for (int c = 0; c < numChannels; ++c)
+            for (int i = 0; i < numSamples; ++i)
+                output[c][i] = applyCronchToSample (input[c][i], amount, dcOffset);
+    }
+
+    BenchConfig config;
+};
+
+template <typename SampleType>
+struct ScalarAbsolutionStage : public Stage<SampleType>
+{
+    void prepare (const BenchConfig& newConfig) override    { config = newConfig; }
+
+    void processBlock (const SampleType* const* input, SampleType* const* output,
+                       int numChannels, int numSamples, int) noexcept override
+    {
+        const auto threshold = (SampleType) config.state->snapshot.absolutionThreshold;
+
+        for (int c = 0; c < numChannels; ++c)
+            for (int i = 0; i < numSamples; ++i)
+                output[c][i] = applyAbsolutionToSample (input[c][i], threshold);
+    }
+
+    BenchConfig config;
+};
+
+const juce::StringArray allStageNames { "processor", "engine", "kernel.ochoAndMix", "kernel.shaper",
+                                        "lpf", "processOcho", "applyCronchToSample", "applyAbsolutionToSample" };
+
+template <typename SampleType>
+std::unique_ptr<Stage<SampleType>> createStage (const juce::String& name)
+{
+    if (name == "processor")                return std::make_unique<ProcessorStage<SampleType>>();
+    if (name == "engine")                   return std::make_unique<EngineStage<SampleType>>();
+    if (name == "kernel.ochoAndMix")        return std::make_unique<KernelOchoStage<SampleType>>();
+    if (name == "kernel.shaper")            return std::make_unique<KernelShaperStage<SampleType>>();
+    if (name == "lpf")                      return std::make_unique<ScalarLowPassStage<SampleType>>();
+    if (name == "processOcho")              return std::make_unique<ScalarOchoStage<SampleType>>();
+    if (name == "applyCronchToSample")      return std::make_unique<ScalarCronchStage<SampleType>>();
+    if (name == "applyAbsolutionToSample")  return std::make_unique<ScalarAbsolutionStage<SampleType>>();
+
+    jassertfalse;
+    return {};
+}
+
+//==============================================================================
+struct BenchOptions
+{
+    juce::StringArray stages { allStageNames };
+    juce::Array<BenchState> states { makeStates() };
+    juce::Array<int> blockSizes { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192 };
+    juce::Array<int> channelCounts { 1, 2, 8 };
+    juce::Array<double> sampleRates { 48000.0, 96000.0 };
+    juce::StringArray precisions { "float" };
+    int samplesPerRun = 1 << 16;    // per channel
+    int numRuns = 5;
+    juce::File outputFile, baselineFile;
+    double tolerance = 0.1;
+};
+
+struct BenchResult
+{
+    double medianSeconds = 0, fastestSeconds = 0;
+    juce::int64 numSamples = 0;     // per channel
+};
+
+volatile double sink = 0;
+
+/** A few harmonics under a slowly wandering envelope, with a little noise:
+    close enough to a DI guitar that the flip-flop sees realistic zero crossings
+    and the shaper sees the whole range.
+*/
+template <typename SampleType>
+juce::AudioBuffer<SampleType> makeTestSignal (int numChannels, int numSamples, double sampleRate)
+{
+    juce::AudioBuffer<SampleType> signal (numChannels, numSamples);
+    juce::Random random (0x1a2b3c);
+
+    for (int c = 0; c < numChannels; ++c)
+    {
+        const auto w = juce::MathConstants<double>::twoPi * (82.41 * (1.0 + 0.5 * c)) / sampleRate;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto envelope = 0.6 + 0.4 * std::sin ((double) i * 2.0e-5);
+            const auto x = std::sin (w * i) + 0.5 * std::sin (2.0 * w * i + 0.3) + 0.25 * std::sin (3.0 * w * i + 1.1);
+            signal.setSample (c, i, (SampleType) (0.5 * envelope * x + 0.01 * (random.nextDouble() - 0.5)));
+        }
+    }
+
+    return signal;
+}
+
+template <typename SampleType>
+BenchResult runBenchmark (Stage<SampleType>& stage, const BenchConfig& config, const BenchOptions& options)
+{
+    const auto numBlocks = juce::jmax (1, (options.samplesPerRun + config.blockSize - 1) / config.blockSize);
+    const auto numSamples = numBlocks * config.blockSize;
+
+    const auto input = makeTestSignal<SampleType> (config.numChannels, numSamples, config.sampleRate);
+    juce::AudioBuffer<SampleType> output (config.numChannels, numSamples);
+
+    std::vector<const SampleType*> in ((size_t) config.numChannels);
+    std::vector<SampleType*> out ((size_t) config.numChannels);
+    std::vector<double> seconds;
+
+    juce::ScopedNoDenormals noDenormals;
+
+    // one untimed run first, to settle caches, branch predictors and clocks
+    for (int run = -1; run < options.numRuns; ++run)
+    {
+        stage.prepare (config);
+
+        const auto start = juce::Time::getHighResolutionTicks();
+
+        for (int b = 0; b < numBlocks; ++b)
+        {
+            for (int c = 0; c < config.numChannels; ++c)
+            {
+                in[(size_t) c] = input.getReadPointer (c, b * config.blockSize);
+                out[(size_t) c] = output.getWritePointer (c, b * config.blockSize);
+            }
+
+            stage.processBlock (in.data(), out.data(), config.numChannels, config.blockSize, b);
+        }
+
+        const auto elapsed = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start);
+
+        // keeps the compiler from discarding output nobody reads
+        sink = sink + (double) output.getSample (0, numSamples - 1);
+
+        if (run >= 0)
+            seconds.push_back (elapsed);
+    }
+
+    std::sort (seconds.begin(), seconds.end());
+    return { seconds[seconds.size() / 2], seconds.front(), numSamples };
+}
+
+//==============================================================================
+juce::String makeKey (const juce::var& r)
+{
+    return r["stage"].toString() + "/" + r["precision"].toString() + "/" + r["state"].toString()
+            + "/" + juce::String (juce::roundToInt ((double) r["sampleRate"])) + "Hz/" + r["channels"].toString() + "ch/" + r["blockSize"].toString();
+}
+
+template <typename SampleType>
+void runSweep (const BenchOptions& options, const juce::String& precision, juce::Array<juce::var>& results)
+{
+    for (const auto& stageName : options.stages)
+    {
+        auto stage = createStage<SampleType> (stageName);
+
+        for (const auto& state : options.states)
+            for (auto sampleRate : options.sampleRates)
+                for (auto numChannels : options.channelCounts)
+                    for (auto blockSize : options.blockSizes)
+                    {
+                        const BenchConfig config { sampleRate, numChannels, blockSize, &state };
+                        const auto r = runBenchmark (*stage, config, options);
+
+                        const auto channelSamples = (double) r.numSamples * numChannels;
+                        const auto nsPerSample = r.medianSeconds * 1.0e9 / channelSamples;
+                        const auto realtimeFactor = ((double) r.numSamples / sampleRate) / r.medianSeconds;
+
+                        juce::var resultVar (new juce::DynamicObject());
+                        auto* result = resultVar.getDynamicObject();
+                        result->setProperty ("stage", stageName);
+                        result->setProperty ("precision", precision);
+                        result->setProperty ("state", state.name);
+                        result->setProperty ("sampleRate", sampleRate);
+                        result->setProperty ("channels", numChannels);
+                        result->setProperty ("blockSize", blockSize);
+                        result->setProperty ("nsPerSample", nsPerSample);
+                        result->setProperty ("fastestNsPerSample", r.fastestSeconds * 1.0e9 / channelSamples);
+                        result->setProperty ("realtimeFactor", realtimeFactor);
+                        results.add (resultVar);
+
+                        std::cout << makeKey (resultVar) << "  " << juce::String (nsPerSample, 2) << " ns/sample  "
+                                  << juce::String (realtimeFactor, 1) << "x realtime" << std::endl;
+                    }
+    }
+}
+
+/** Prints the change from the baseline for every result they have in common.
+    Returns the number of results that got slower by more than the tolerance.
+*/
+int compareWithBaseline (const juce::Array<juce::var>& results, const juce::var& baseline, double tolerance)
+{
+    std::map<juce::String, double> baselineTimes;
+
+    if (auto* baselineResults = baseline["results"].getArray())
+        for (const auto& r : *baselineResults)
+            baselineTimes[makeKey (r)] = (double) r["nsPerSample"];
+
+    int numCompared = 0, numRegressions = 0;
+
+    std::cout << "\nCompared with baseline:" << std::endl;
+
+    for (const auto& r : results)
+    {
+        const auto found = baselineTimes.find (makeKey (r));
+
+        if (found == baselineTimes.end() || found->second <= 0)
+            continue;
+
+        ++numCompared;
+        const auto change = (double) r["nsPerSample"] / found->second - 1.0;
+        const auto regressed = change > tolerance;
+        numRegressions += regressed ? 1 : 0;
+
+        std::cout << (regressed ? "SLOWER " : "       ") << makeKey (r) << "  "
+                  << (change >= 0 ? "+" : "") << juce::String (change * 100.0, 1) << "%" << std::endl;
+    }
+
+    std::cout << numCompared << " compared, " << numRegressions << " slower by more than "
+              << juce::String (tolerance * 100.0, 0) << "%" << std::endl;
+
+    return numRegressions;
+}
+
+//==============================================================================
+void printUsage()
+{
+    std::cout << "Usage: intrusion-bench [options]\n"
+                 "\n"
+                 "Times the plugin, the engine and each DSP stage, reporting ns per\n"
+                 "channel-sample and realtime factor. Build in Release; numbers from a debug\n"
+                 "build mean nothing.\n"
+                 "\n"
+                 "Options (lists are comma separated):\n"
+                 "  --stages <list>       of: " << allStageNames.joinIntoString (", ") << "\n"
+                 "  --states <list>       of: default, full, fast, adaa, oversampled4x, automated\n"
+                 "  --block-sizes <list>  default 16 to 8192 in powers of two\n"
+                 "  --channels <list>     default 1,2,8\n"
+                 "  --rates <list>        default 48000,96000\n"
+                 "  --precision <p>       float, double or both (default float)\n"
+                 "  --samples <n>         samples per channel per timed run (default 65536)\n"
+                 "  --runs <n>            timed runs per measurement; the median is reported (default 5)\n"
+                 "  --quick               512 and 64 sample blocks, stereo, 48 kHz\n"
+                 "  --out <file>          write the results as JSON\n"
+                 "  --baseline <file>     compare with an earlier --out file; exits with 1 if\n"
+                 "                        anything got slower by more than the tolerance\n"
+                 "  --tolerance <pct>     allowed slowdown against the baseline (default 10)\n";
+}
+
+template <typename NumberType>
+juce::Array<NumberType> parseList (const juce::String& text)
+{
+    juce::Array<NumberType> values;
+
+    for (const auto& token : juce::StringArray::fromTokens (text, ",", {}))
+        values.add ((NumberType) token.trim().getDoubleValue());
+
+    return values;
+}
+
+} // namespace
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    // The processor's parameter tree uses a timer, which needs a message manager
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    BenchOptions options;
+    juce::StringArray args;
+
+    for (int i = 1; i < argc; ++i)
+        args.add (juce::CharPointer_UTF8 (argv[i]));
+
+    if (args.contains ("--help") || args.contains ("-h"))
+    {
+        printUsage();
+        return 0;
+    }
+
+    auto fail = [] (const juce::String& message)
+    {
+        std::cerr << "intrusion-bench: " << message << std::endl;
+        return 2;
+    };
+
+    for (int i = 0; i < args.size(); ++i)
+    {
+        const auto& arg = args[i];
+
+        if (arg == "--quick")
+        {
+            options.blockSizes = { 64, 512 };
+            options.channelCounts = { 2 };
+            options.sampleRates = { 48000.0 };
+            continue;
+        }
+
+        if (! arg.startsWith ("--") || i + 1 >= args.size())
+            return fail ("bad argument " + arg + ", see --help");
+
+        const auto value = args[++i];
+
+        if (arg == "--stages")
+        {
+            options.stages = juce::StringArray::fromTokens (value, ",", {});
+            options.stages.trim();
+
+            for (const auto& s : options.stages)
+                if (! allStageNames.contains (s))
+                    return fail ("unknown stage " + s);
+        }
+        else if (arg == "--states")
+        {
+            const auto names = juce::StringArray::fromTokens (value, ",", {});
+            const auto allStates = makeStates();
+            options.states.clear();
+
+            for (const auto& name : names)
+            {
+                const auto* found = std::find_if (allStates.begin(), allStates.end(),
+                                                  [&] (const BenchState& s) { return s.name == name.trim(); });
+
+                if (found == allStates.end())
+                    return fail ("unknown state " + name);
+
+                options.states.add (*found);
+            }
+        }
+        else if (arg == "--block-sizes")    options.blockSizes = parseList<int> (value);
+        else if (arg == "--channels")       options.channelCounts = parseList<int> (value);
+        else if (arg == "--rates")          options.sampleRates = parseList<double> (value);
+        else if (arg == "--samples")        options.samplesPerRun = juce::jmax (16, value.getIntValue());
+        else if (arg == "--runs")           options.numRuns = juce::jmax (1, value.getIntValue());
+        else if (arg == "--out")            options.outputFile = juce::File::getCurrentWorkingDirectory().getChildFile (value);
+        else if (arg == "--baseline")       options.baselineFile = juce::File::getCurrentWorkingDirectory().getChildFile (value);
+        else if (arg == "--tolerance")      options.tolerance = value.getDoubleValue() / 100.0;
+        else if (arg == "--precision")
+        {
+            if (value == "both")                            options.precisions = { "float", "double" };
+            else if (value == "float" || value == "double") options.precisions = { value };
+            else                                            return fail ("unknown precision " + value);
+        }
+        else
+        {
+            return fail ("unknown option " + arg);
+        }
+    }
+
+    for (auto n : options.channelCounts)
+        if (n < 1 || n > IntrusionEngine::maxChannels)
+            return fail ("channel counts must be 1 to " + juce::String (IntrusionEngine::maxChannels));
+
+    for (auto n : options.blockSizes)
+        if (n < 1)
+            return fail ("block sizes must be positive");
+
+    juce::Array<juce::var> results;
+
+    for (const auto& precision : options.precisions)
+    {
+        if (precision == "double")
+            runSweep<double> (options, precision, results);
+        else
+            runSweep<float> (options, precision, results);
+    }
+
+    if (options.outputFile != juce::File())
+    {
+        auto* report = new juce::DynamicObject();
+        report->setProperty ("version", 1);
+        report->setProperty ("simdBytes", (int) juce::dsp::SIMDRegister<float>::SIMDRegisterSize);
+        report->setProperty ("cpu", juce::SystemStats::getCpuModel());
+        report->setProperty ("date", juce::Time::getCurrentTime().toISO8601 (true));
+        report->setProperty ("samplesPerRun", options.samplesPerRun);
+        report->setProperty ("runs", options.numRuns);
+        report->setProperty ("results", results);
+
+        if (! options.outputFile.replaceWithText (juce::JSON::toString (juce::var (report))))
+            return fail ("can't write " + options.outputFile.getFullPathName());
+    }
+
+    if (options.baselineFile != juce::File())
+    {
+        const auto baseline = juce::JSON::parse (options.baselineFile);
+
+        if (! baseline.isObject())
+            return fail ("can't read baseline " + options.baselineFile.getFullPathName());
+
+        return compareWithBaseline (results, baseline, options.tolerance) > 0 ? 1 : 0;
+    }
+
+    return 0;
+}
@@ -0,0 +1,180 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    intrusion-presets: packs a folder of preset files into one memory-mapped
+    preset library, and lists, searches and prints what's in a library
+    without unpacking it.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "PresetLibrary.h"
+
+namespace
+{
+
+// What a folder is searched for; files named on their own are read whatever they're called
+const juce::String presetFileWildcards = juce::String ("*") + PresetState::fileExtension + ";*.xml";
+
+//==============================================================================
+void printUsage()
+{
+    std::cout << "Usage: intrusion-presets <command> <library> [arguments]\n"
+                 "\n"
+                 "Commands:\n"
+                 "  build <library> <file or folder>...   pack preset files into a library,\n"
+                 "                                        named after each file\n"
+                 "  list <library> [text]                 names containing text, or every name\n"
+                 "  show <library> <name>                 every parameter of one preset\n"
+                 "  export <library> <name> <file>        one preset as a plugin state file\n"
+                 "\n"
+                 "Preset files may be plugin states (binary or the older ValueTree form) or\n"
+                 "XML. Folders are searched for " << PresetState::fileExtension << " and .xml files.\n"
+                 "Libraries use the " << PresetLibrary::fileExtension << " extension.\n";
+}
+
+int fail (const juce::String& message)
+{
+    std::cerr << "intrusion-presets: " << message << std::endl;
+    return 2;
+}
+
+juce::File getFile (const juce::String& path)
+{
+    return juce::File::getCurrentWorkingDirectory().getChildFile (path);
+}
+
+//==============================================================================
+int build (const juce::File& libraryFile, const juce::StringArray& sources)
+{
+    juce::Array<juce::File> files;
+
+    for (const auto& source : sources)
+    {
+        const auto file = getFile (source);
+
+        if (file.isDirectory())
+            files.addArray (file.findChildFiles (juce::File::findFiles, true, presetFileWildcards));
+        else if (file.existsAsFile())
+            files.add (file);
+        else
+            return fail ("can't find " + file.getFullPathName());
+    }
+
+    juce::Array<PresetLibrary::Preset> presets;
+    juce::StringArray names;
+
+    files.removeAllInstancesOf (libraryFile);
+
+    for (const auto& file : files)
+    {
+        juce::MemoryBlock data;
+        IntrusionEngine::ParameterSnapshot snapshot;
+
+        if (! file.loadFileAsData (data) || PresetState::read (data.getData(), data.getSize(), snapshot).failed())
+        {
+            std::cerr << "skipping " << file.getFullPathName() << ": not a preset" << std::endl;
+            continue;
+        }
+
+        const auto name = file.getFileNameWithoutExtension();
+
+        if (names.contains (name, true))
+            return fail ("two presets called " + name);
+
+        // Stored in the current binary format, whatever form the file was in
+        names.add (name);
+        presets.add ({ name, PresetState::write (snapshot) });
+    }
+
+    const auto result = PresetLibrary::write (libraryFile, presets);
+
+    if (result.failed())
+        return fail (result.getErrorMessage());
+
+    std::cout << presets.size() << " presets written to " << libraryFile.getFullPathName() << std::endl;
+    return 0;
+}
+
+int list (const PresetLibrary& library, const juce::String& text)
+{
+    for (auto index : library.search (text))
+        std::cout << library.getName (index) << "\n";
+
+    return 0;
+}
+
+int show (const PresetLibrary& library, const juce::String& name)
+{
+    IntrusionEngine::ParameterSnapshot snapshot;
+    const auto result = library.loadPreset (library.indexOf (name), snapshot);
+
+    if (result.failed())
+        return fail ("no preset called " + name);
+
+    for (const auto* id : PresetState::parameterIDs)
+        std::cout << juce::String (id).paddedRight (' ', 22) << snapshot.getRawValue (id) << "\n";
+
+    return 0;
+}
+
+int exportPreset (const PresetLibrary& library, const juce::String& name, const juce::File& file)
+{
+    IntrusionEngine::ParameterSnapshot snapshot;
+
+    if (library.loadPreset (library.indexOf (name), snapshot).failed())
+        return fail ("no preset called " + name);
+
+    const auto state = PresetState::write (snapshot);
+
+    if (! file.replaceWithData (state.getData(), state.getSize()))
+        return fail ("can't write " + file.getFullPathName());
+
+    return 0;
+}
+
+} // namespace
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::StringArray args;
+
+    for (int i = 1; i < argc; ++i)
+        args.add (juce::CharPointer_UTF8 (argv[i]));
+
+    if (args.isEmpty() || args.contains ("--help") || args.contains ("-h"))
+    {
+        printUsage();
+        return args.isEmpty() ? 2 : 0;
+    }
+
+    if (args.size() < 2)
+        return fail ("no library given, see --help");
+
+    const auto command = args[0];
+    const auto libraryFile = getFile (args[1]);
+
+    if (command == "build")
+    {
+        if (args.size() < 3)
+            return fail ("build needs at least one preset file or folder");
+
+        return build (libraryFile, juce::StringArray (args.begin() + 2, args.size() - 2));
+    }
+
+    PresetLibrary library;
+    const auto opened = library.open (libraryFile);
+
+    if (opened.failed())
+        return fail (opened.getErrorMessage());
+
+    if (command == "list")                          return list (library, args[2]);
+    if (command == "show" && args.size() == 3)      return show (library, args[2]);
+    if (command == "export" && args.size() == 4)    return exportPreset (library, args[2], getFile (args[3]));
+
+    return fail ("bad command " + command + ", see --help");
+}
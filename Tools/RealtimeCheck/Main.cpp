@@ -0,0 +1,306 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    intrusion-realtime-check: drives the plugin processor the way a host does
+    while RealtimeSafety watches the audio thread. It plays through a range of
+    bus layouts, sample rates, block sizes and both precisions, with every
+    parameter automated (including the choices that switch oversampling and
+    filter slope), state saves and restores between blocks, re-prepares, and
+    stretches of silence that put the engine into and out of its idle bypass.
+
+    It first checks that the checker catches an AudioBuffer growing on the
+    audio thread. Then any allocation, lock or system call inside processBlock
+    fails the run, as does non-finite output. Automation is applied on the
+    audio thread, as the VST3 and AU wrappers do, so parameter listeners are
+    checked too, and the processor mustn't notify the host (e.g. of a new
+    latency) from there. Built with INTRUSION_REALTIME_CHECKS=1 and registered
+    with CTest, see Tools/CMakeLists.txt.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include "RealtimeSafety.h"
+
+namespace
+{
+
+//==============================================================================
+/** Counts anything the processor tells the host while on the audio thread. */
+struct HostNotificationCheck : public juce::AudioProcessorListener
+{
+    void audioProcessorParameterChanged (juce::AudioProcessor*, int, float) override {}
+
+    void audioProcessorChanged (juce::AudioProcessor*, const ChangeDetails&) override
+    {
+        if (RealtimeSafety::isAudioThread())
+            ++numFromAudioThread;
+    }
+
+    int numFromAudioThread = 0;
+};
+
+struct Scenario
+{
+    const char* name;
+    juce::AudioChannelSet layout;
+    double sampleRate;
+    int maximumBlockSize;
+    bool doublePrecision;
+};
+
+class RealtimeCheck
+{
+public:
+    explicit RealtimeCheck (juce::int64 seed) : random (seed) {}
+
+    /** Returns the number of problems found. */
+    int run (const Scenario& scenario)
+    {
+        std::cout << scenario.name << std::endl;
+
+        INTRUSIONAudioProcessor processor;
+        HostNotificationCheck hostNotifications;
+        processor.addListener (&hostNotifications);
+
+        juce::AudioProcessor::BusesLayout layout;
+        layout.inputBuses.add (scenario.layout);
+        layout.outputBuses.add (scenario.layout);
+
+        if (! processor.setBusesLayout (layout))
+        {
+            std::cerr << "  layout not accepted" << std::endl;
+            return 1;
+        }
+
+        processor.setProcessingPrecision (scenario.doublePrecision ? juce::AudioProcessor::doublePrecision
+                                                                   : juce::AudioProcessor::singlePrecision);
+        processor.prepareToPlay (scenario.sampleRate, scenario.maximumBlockSize);
+
+        const auto violationsBefore = RealtimeSafety::getNumViolations();
+        const auto numChannels = scenario.layout.size();
+
+        // allocated up front at the largest size; shorter blocks only shrink the view
+        juce::AudioBuffer<float> floatBuffer (numChannels, scenario.maximumBlockSize);
+        juce::AudioBuffer<double> doubleBuffer (numChannels, scenario.maximumBlockSize);
+        juce::MidiBuffer midi;
+
+        int nonFiniteBlocks = 0;
+        juce::int64 position = 0;
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            // everything a host might do between two callbacks
+            automateParameters (processor, block);
+
+            if (block % 400 == 399)
+                roundTripState (processor);
+
+            if (block == numBlocks / 2)
+                processor.prepareToPlay (scenario.sampleRate, scenario.maximumBlockSize);
+
+            // hosts may send any block size up to the prepared maximum
+            const auto numSamples = random.nextInt (4) == 0 ? 1 + random.nextInt (scenario.maximumBlockSize)
+                                                            : scenario.maximumBlockSize;
+            const auto silent = (block / 150) % 4 == 3;
+
+            if (scenario.doublePrecision)
+            {
+                doubleBuffer.setSize (numChannels, numSamples, false, false, true);
+                fillInput (doubleBuffer, position, scenario.sampleRate, silent);
+                processor.processBlock (doubleBuffer, midi);
+                nonFiniteBlocks += isFinite (doubleBuffer) ? 0 : 1;
+            }
+            else
+            {
+                floatBuffer.setSize (numChannels, numSamples, false, false, true);
+                fillInput (floatBuffer, position, scenario.sampleRate, silent);
+                processor.processBlock (floatBuffer, midi);
+                nonFiniteBlocks += isFinite (floatBuffer) ? 0 : 1;
+            }
+
+            position += numSamples;
+        }
+
+        processor.releaseResources();
+        processor.removeListener (&hostNotifications);
+
+        const auto violations = RealtimeSafety::getNumViolations() - violationsBefore;
+
+        if (violations > 0)
+            std::cerr << "  " << violations << " realtime violations" << std::endl;
+
+        if (nonFiniteBlocks > 0)
+            std::cerr << "  " << nonFiniteBlocks << " blocks with NaN or infinite output" << std::endl;
+
+        if (hostNotifications.numFromAudioThread > 0)
+            std::cerr << "  " << hostNotifications.numFromAudioThread << " host notifications from the audio thread" << std::endl;
+
+        return violations + nonFiniteBlocks + hostNotifications.numFromAudioThread;
+    }
+
+private:
+    static constexpr int numBlocks = 2000;
+    juce::Random random;
+
+    /** Moves a few parameters per block. Most moves are small, as from a
+        recorded automation lane; some jump to anywhere in the range.
+
+        The VST3 and AU wrappers apply automation on the audio thread, just
+        before processBlock, so this does too, and any parameter listener that
+        allocates or reaches the host gets caught. JUCE's listener dispatch
+        itself takes a lock there in every wrapper, so locks are let through.
+    */
+    void automateParameters (juce::AudioProcessor& processor, int block)
+    {
+        const RealtimeSafety::ScopedAudioThread audioThread;
+        const RealtimeSafety::ScopedLocksAllowed listenerLock;
+
+        const auto& parameters = processor.getParameters();
+
+        for (auto* parameter : parameters)
+        {
+            if (random.nextInt (8) != 0)
+                continue;
+
+            const auto jump = random.nextInt (10) == 0;
+            const auto value = jump ? random.nextFloat()
+                                    : parameter->getValue() + 0.05f * (random.nextFloat() - 0.5f);
+
+            parameter->beginChangeGesture();
+            parameter->setValueNotifyingHost (juce::jlimit (0.0f, 1.0f, value));
+            parameter->endChangeGesture();
+        }
+
+        // Every so often, everything at once: full octaves, steepest slope, 8x
+        if (block % 250 == 0)
+            for (auto* parameter : parameters)
+                parameter->setValueNotifyingHost (random.nextBool() ? 1.0f : parameter->getDefaultValue());
+    }
+
+    /** Saves the state, changes the parameters, then restores it, as a host
+        does when switching presets or undoing.
+    */
+    void roundTripState (juce::AudioProcessor& processor)
+    {
+        juce::MemoryBlock state;
+        processor.getStateInformation (state);
+
+        for (auto* parameter : processor.getParameters())
+            parameter->setValueNotifyingHost (random.nextFloat());
+
+        processor.setStateInformation (state.getData(), (int) state.getSize());
+    }
+
+    template <typename SampleType>
+    static void fillInput (juce::AudioBuffer<SampleType>& buffer, juce::int64 position, double sampleRate, bool silent)
+    {
+        if (silent)
+        {
+            buffer.clear();
+            return;
+        }
+
+        for (int c = 0; c < buffer.getNumChannels(); ++c)
+        {
+            const auto w = juce::MathConstants<double>::twoPi * 110.0 * (1.0 + 0.25 * c) / sampleRate;
+
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+            {
+                const auto t = (double) (position + i);
+                buffer.setSample (c, i, (SampleType) (0.7 * std::sin (w * t) + 0.2 * std::sin (3.0 * w * t)));
+            }
+        }
+    }
+
+    template <typename SampleType>
+    static bool isFinite (const juce::AudioBuffer<SampleType>& buffer)
+    {
+        for (int c = 0; c < buffer.getNumChannels(); ++c)
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+                if (! std::isfinite (buffer.getSample (c, i)))
+                    return false;
+
+        return true;
+    }
+};
+
+//==============================================================================
+/** Growing an AudioBuffer on the audio thread must be caught. It allocates
+    through HeapBlock's malloc and realloc rather than operator new, so this
+    fails if only operator new is being watched. Returns 1 if it's missed.
+*/
+int checkBufferResizeIsCaught()
+{
+   #if JUCE_LINUX
+    std::cout << "AudioBuffer::setSize on the audio thread (must be reported)" << std::endl;
+
+    juce::AudioBuffer<float> buffer (2, 64);
+    const auto violationsBefore = RealtimeSafety::getNumViolations();
+
+    {
+        const RealtimeSafety::ScopedAudioThread audioThread;
+        buffer.setSize (2, 1 << 16);
+    }
+
+    const auto caught = RealtimeSafety::getNumViolations() > violationsBefore;
+    RealtimeSafety::resetViolations();
+
+    if (! caught)
+    {
+        std::cerr << "  not reported: allocations through malloc aren't being watched" << std::endl;
+        return 1;
+    }
+   #endif
+
+    return 0;
+}
+
+} // namespace
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    // The parameter tree uses a timer, which needs a message manager
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::StringArray args;
+
+    for (int i = 1; i < argc; ++i)
+        args.add (juce::CharPointer_UTF8 (argv[i]));
+
+    if (args.contains ("--trap"))
+        RealtimeSafety::setMode (RealtimeSafety::Mode::trap);
+
+    if (! RealtimeSafety::isEnabled())
+    {
+        std::cerr << "intrusion-realtime-check: built without INTRUSION_REALTIME_CHECKS, nothing would be caught" << std::endl;
+        return 1;
+    }
+
+    const Scenario scenarios[] =
+    {
+        { "stereo, 44.1 kHz, 512, float",       juce::AudioChannelSet::stereo(),              44100.0,  512, false },
+        { "stereo, 48 kHz, 64, double",         juce::AudioChannelSet::stereo(),              48000.0,   64, true  },
+        { "mono, 96 kHz, 1024, float",          juce::AudioChannelSet::mono(),                96000.0, 1024, false },
+        { "7.1.4, 48 kHz, 256, float",          juce::AudioChannelSet::create7point1point4(), 48000.0,  256, false },
+        { "7.1.4, 192 kHz, 2048, double",       juce::AudioChannelSet::create7point1point4(), 192000.0, 2048, true },
+    };
+
+    int problems = 0;
+
+    // In trap mode the first violation aborts, so the checker's own check is skipped
+    if (! args.contains ("--trap"))
+        problems += checkBufferResizeIsCaught();
+
+    RealtimeCheck check (args.contains ("--seed") ? args[args.indexOf ("--seed") + 1].getLargeIntValue() : 1);
+
+    for (const auto& scenario : scenarios)
+        problems += check.run (scenario);
+
+    std::cout << (problems == 0 ? "No realtime violations" : "FAILED") << std::endl;
+    return problems == 0 ? 0 : 1;
+}
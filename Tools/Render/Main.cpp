@@ -0,0 +1,451 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    intrusion-render: runs audio files through the INTRUSION DSP core without
+    a plugin host, e.g. to reamp a folder of DI stems overnight.
+
+    Each file streams through reader -> IntrusionEngine -> writer in fixed-size
+    blocks, so memory use doesn't depend on file length. WAV and AIFF inputs
+    are memory-mapped; writing happens on a background thread; and files are
+    spread across a thread pool, one engine per file.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "IntrusionEngine.h"
+#include "PresetLibrary.h"
+
+namespace
+{
+
+//==============================================================================
+struct RenderSettings
+{
+    IntrusionEngine::ParameterSnapshot parameters;
+    juce::File outputDirectory;             // next to each input if not set
+    juce::String suffix { "_intrusion" };
+    juce::String outputExtension;           // same format as the input if empty
+    int bitsPerSample = 0;                  // same as the input if 0
+    int blockSize = 512;
+    bool doublePrecision = false;
+    bool includeTail = false;
+};
+
+const char* const audioFileWildcards = "*.wav;*.wave;*.aif;*.aiff;*.flac";
+
+/** A file to render. Files found in a folder keep their path below that
+    folder, so a tree of inputs renders to the same tree under --out.
+*/
+struct RenderInput
+{
+    juce::File file;
+    juce::String subfolder;     // relative to the folder it was found in, or empty
+};
+
+/** Where an input's render goes, or an invalid file if the output format is unknown. */
+juce::File getOutputFile (const RenderInput& input, const RenderSettings& settings, juce::AudioFormatManager& formatManager)
+{
+    auto* outputFormat = settings.outputExtension.isEmpty() ? formatManager.findFormatForFileExtension (input.file.getFileExtension())
+                                                            : formatManager.findFormatForFileExtension (settings.outputExtension);
+
+    if (outputFormat == nullptr)
+        return {};
+
+    const auto outputDirectory = settings.outputDirectory == juce::File() ? input.file.getParentDirectory()
+                                                                          : settings.outputDirectory.getChildFile (input.subfolder);
+
+    return outputDirectory.getChildFile (input.file.getFileNameWithoutExtension() + settings.suffix
+                                           + outputFormat->getFileExtensions()[0]);
+}
+
+//==============================================================================
+/** Reads a preset and applies every parameter it contains. The preset is either
+    a state file (the plugin's binary state, an older ValueTree state, or the
+    same tree as XML), or library.intrusionpresets:name for one preset from a
+    preset library.
+*/
+juce::Result loadPreset (const juce::String& preset, IntrusionEngine::ParameterSnapshot& parameters)
+{
+    const auto libraryPath = preset.upToLastOccurrenceOf (":", false, false);
+
+    if (libraryPath.endsWithIgnoreCase (PresetLibrary::fileExtension))
+    {
+        PresetLibrary library;
+        const auto opened = library.open (juce::File::getCurrentWorkingDirectory().getChildFile (libraryPath));
+
+        if (opened.failed())
+            return opened;
+
+        const auto name = preset.fromLastOccurrenceOf (":", false, false);
+        const auto index = library.indexOf (name);
+
+        if (index < 0)
+            return juce::Result::fail ("no preset called " + name + " in " + libraryPath);
+
+        return library.loadPreset (index, parameters);
+    }
+
+    const auto file = juce::File::getCurrentWorkingDirectory().getChildFile (preset);
+    juce::MemoryBlock data;
+
+    if (! file.loadFileAsData (data))
+        return juce::Result::fail ("can't read preset " + file.getFullPathName());
+
+    const auto result = PresetState::read (data.getData(), data.getSize(), parameters);
+
+    if (result.failed())
+        return juce::Result::fail ("can't read preset " + file.getFullPathName() + ": " + result.getErrorMessage());
+
+    return result;
+}
+
+//==============================================================================
+/** Collects results from the render threads and prints them as they arrive. */
+class Progress
+{
+public:
+    explicit Progress (int totalFiles) : total (totalFiles) {}
+
+    void finished (const juce::File& input, const juce::Result& result, double realtimeFactor)
+    {
+        const juce::ScopedLock sl (lock);
+
+        ++done;
+
+        if (result.wasOk())
+        {
+            std::cout << "[" << done << "/" << total << "] " << input.getFullPathName()
+                      << " (" << juce::String (realtimeFactor, 1) << "x realtime)" << std::endl;
+        }
+        else
+        {
+            ++failed;
+            std::cerr << "[" << done << "/" << total << "] FAILED " << input.getFullPathName()
+                      << ": " << result.getErrorMessage() << std::endl;
+        }
+
+        if (done == total)
+            allDone.signal();
+    }
+
+    void waitUntilFinished()        { allDone.wait(); }
+    int getNumFailed() const        { const juce::ScopedLock sl (lock); return failed; }
+
+private:
+    juce::CriticalSection lock;
+    juce::WaitableEvent allDone;
+    const int total;
+    int done = 0, failed = 0;
+};
+
+//==============================================================================
+class RenderJob : public juce::ThreadPoolJob
+{
+public:
+    RenderJob (const RenderInput& renderInput, const RenderSettings& renderSettings,
+               juce::TimeSliceThread& writerThread, Progress& progressToReport)
+        : juce::ThreadPoolJob (renderInput.file.getFileName()),
+          input (renderInput.file), subfolder (renderInput.subfolder),
+          settings (renderSettings), writeThread (writerThread), progress (progressToReport)
+    {
+        formatManager.registerBasicFormats();
+    }
+
+    JobStatus runJob() override
+    {
+        const auto startTime = juce::Time::getMillisecondCounterHiRes();
+        double audioSeconds = 0.0;
+        const auto result = render (audioSeconds);
+        const auto elapsedSeconds = (juce::Time::getMillisecondCounterHiRes() - startTime) * 0.001;
+
+        progress.finished (input, result, audioSeconds / juce::jmax (1.0e-6, elapsedSeconds));
+        return jobHasFinished;
+    }
+
+private:
+    juce::Result render (double& audioSeconds)
+    {
+        auto* inputFormat = formatManager.findFormatForFileExtension (input.getFileExtension());
+
+        if (inputFormat == nullptr)
+            return juce::Result::fail ("unsupported file type");
+
+        // WAV and AIFF are read straight out of a memory map; anything that
+        // needs decoding, such as FLAC, goes through a buffered stream instead
+        std::unique_ptr<juce::AudioFormatReader> reader;
+        std::unique_ptr<juce::MemoryMappedAudioFormatReader> mappedReader (inputFormat->createMemoryMappedReader (input));
+
+        if (mappedReader != nullptr && mappedReader->mapEntireFile())
+            reader = std::move (mappedReader);
+        else
+            reader.reset (formatManager.createReaderFor (input));
+
+        if (reader == nullptr)
+            return juce::Result::fail ("can't read the file");
+
+        const auto numChannels = (int) reader->numChannels;
+        const auto sampleRate = reader->sampleRate;
+
+        if (numChannels > IntrusionEngine::maxChannels)
+            return juce::Result::fail ("more than " + juce::String (IntrusionEngine::maxChannels) + " channels");
+
+        auto* outputFormat = settings.outputExtension.isEmpty() ? inputFormat
+                                                                : formatManager.findFormatForFileExtension (settings.outputExtension);
+
+        if (outputFormat == nullptr)
+            return juce::Result::fail ("unknown output format " + settings.outputExtension);
+
+        const auto output = getOutputFile ({ input, subfolder }, settings, formatManager);
+
+        if (output == input)
+            return juce::Result::fail ("the output would overwrite the input");
+
+        auto writer = createWriter (*outputFormat, output, *reader, outputFormat == inputFormat);
+
+        if (writer == nullptr)
+            return juce::Result::fail ("can't write " + output.getFullPathName());
+
+        // The engine stays prepared for the whole file, so its smoothers start
+        // settled on the preset and never move
+        IntrusionEngine engine;
+        engine.prepare (sampleRate, settings.blockSize, numChannels, settings.doublePrecision, settings.parameters);
+
+        // Oversampling delays the output, so that much is skipped at the start
+        // and flushed through at the end, keeping the output aligned with the input
+        const auto latency = (juce::int64) engine.getLatencySamples();
+        const auto tail = settings.includeTail ? (juce::int64) std::ceil (IntrusionEngine::getTailLengthSeconds (settings.parameters) * sampleRate) : 0;
+        const auto outputLength = reader->lengthInSamples + tail;
+
+        juce::AudioBuffer<float> buffer (numChannels, settings.blockSize);
+        juce::AudioBuffer<double> doubleBuffer (settings.doublePrecision ? numChannels : 0, settings.blockSize);
+        std::vector<const float*> channels ((size_t) numChannels);
+
+        for (juce::int64 position = 0, written = 0; written < outputLength;)
+        {
+            const auto numSamples = (int) juce::jmin ((juce::int64) settings.blockSize, outputLength + latency - position);
+            buffer.setSize (numChannels, numSamples, false, false, true);
+
+            // past the end of the file the reader fills in silence
+            reader->read (&buffer, 0, numSamples, position, true, true);
+
+            if (settings.doublePrecision)
+            {
+                doubleBuffer.makeCopyOf (buffer, true);
+                engine.process (doubleBuffer, numChannels, settings.parameters);
+                buffer.makeCopyOf (doubleBuffer, true);
+            }
+            else
+            {
+                engine.process (buffer, numChannels, settings.parameters);
+            }
+
+            const auto skip = (int) juce::jlimit ((juce::int64) 0, (juce::int64) numSamples, latency - position);
+            const auto numToWrite = (int) juce::jmin ((juce::int64) (numSamples - skip), outputLength - written);
+
+            for (int c = 0; c < numChannels; ++c)
+                channels[(size_t) c] = buffer.getReadPointer (c, skip);
+
+            // the writer thread drains its FIFO in the background; wait for room if it falls behind
+            while (! writer->write (channels.data(), numToWrite))
+                juce::Thread::sleep (1);
+
+            position += numSamples;
+            written += numToWrite;
+        }
+
+        audioSeconds = (double) outputLength / sampleRate;
+        return juce::Result::ok();
+    }
+
+    std::unique_ptr<juce::AudioFormatWriter::ThreadedWriter> createWriter (juce::AudioFormat& format, const juce::File& output,
+                                                                           const juce::AudioFormatReader& reader, bool sameFormat)
+    {
+        auto bits = settings.bitsPerSample > 0 ? settings.bitsPerSample : (int) reader.bitsPerSample;
+        const auto possibleBits = format.getPossibleBitDepths();
+
+        if (! possibleBits.contains (bits) && ! possibleBits.isEmpty())
+            bits = possibleBits.getLast();
+
+        if (! output.getParentDirectory().createDirectory() || ! output.deleteFile())
+            return {};
+
+        auto stream = output.createOutputStream();
+
+        if (stream == nullptr)
+            return {};
+
+        // metadata chunks only carry over between files of the same format
+        std::unique_ptr<juce::AudioFormatWriter> writer (format.createWriterFor (stream.get(), reader.sampleRate, reader.numChannels, bits,
+                                                                                 sameFormat ? reader.metadataValues : juce::StringPairArray(), 0));
+
+        if (writer == nullptr)
+            return {};
+
+        stream.release(); // now owned by the writer
+        return std::make_unique<juce::AudioFormatWriter::ThreadedWriter> (writer.release(), writeThread, 8 * settings.blockSize);
+    }
+
+    const juce::File input;
+    const juce::String subfolder;
+    const RenderSettings& settings;
+    juce::TimeSliceThread& writeThread;
+    Progress& progress;
+    juce::AudioFormatManager formatManager;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RenderJob)
+};
+
+//==============================================================================
+void printUsage()
+{
+    std::cout << "Usage: intrusion-render [options] <file or folder>...\n"
+                 "\n"
+                 "Processes WAV, AIFF and FLAC files through INTRUSION. Folders are searched\n"
+                 "recursively; files that already end in the output suffix are skipped.\n"
+                 "\n"
+                 "Options:\n"
+                 "  --preset <file>       plugin state or XML preset to load first, or\n"
+                 "                        <library>.intrusionpresets:<name> for one from a library\n"
+                 "  --set <id>=<value>    set one parameter by ID, e.g. --set cronchAmount=12\n"
+                 "                        (raw values: choices are indices, switches 0 or 1)\n"
+                 "  --out <folder>        write here instead of next to each input, keeping\n"
+                 "                        the layout of any folders given\n"
+                 "  --suffix <text>       added to each output name (default _intrusion)\n"
+                 "  --format <ext>        wav, aiff or flac (default: same as the input)\n"
+                 "  --bits <n>            output bit depth (default: same as the input)\n"
+                 "  --block <samples>     processing block size (default 512)\n"
+                 "  --threads <n>         files rendered at once (default: one per CPU)\n"
+                 "  --double              process in double precision\n"
+                 "  --tail                keep the filter ring-out after the input ends\n";
+}
+
+} // namespace
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    RenderSettings settings;
+    auto numThreads = juce::SystemStats::getNumCpus();
+    juce::Array<RenderInput> inputs;
+
+    juce::StringArray args;
+
+    for (int i = 1; i < argc; ++i)
+        args.add (juce::CharPointer_UTF8 (argv[i]));
+
+    if (args.isEmpty() || args.contains ("--help") || args.contains ("-h"))
+    {
+        printUsage();
+        return args.isEmpty() ? 2 : 0;
+    }
+
+    auto fail = [] (const juce::String& message)
+    {
+        std::cerr << "intrusion-render: " << message << std::endl;
+        return 2;
+    };
+
+    for (int i = 0; i < args.size(); ++i)
+    {
+        const auto& arg = args[i];
+
+        if (arg.startsWith ("--") && arg != "--double" && arg != "--tail" && i + 1 >= args.size())
+            return fail (arg + " needs a value");
+
+        if (arg == "--preset")
+        {
+            const auto result = loadPreset (args[++i], settings.parameters);
+
+            if (result.failed())
+                return fail (result.getErrorMessage());
+        }
+        else if (arg == "--set")
+        {
+            const auto assignment = args[++i];
+            const auto id = assignment.upToFirstOccurrenceOf ("=", false, false).trim();
+
+            if (! assignment.contains ("=") || ! settings.parameters.setRawValue (id, assignment.fromFirstOccurrenceOf ("=", false, false).getFloatValue()))
+                return fail ("unknown parameter in --set " + assignment);
+        }
+        else if (arg == "--out")        settings.outputDirectory = juce::File::getCurrentWorkingDirectory().getChildFile (args[++i]);
+        else if (arg == "--suffix")     settings.suffix = args[++i];
+        else if (arg == "--format")     settings.outputExtension = args[++i];
+        else if (arg == "--bits")       settings.bitsPerSample = args[++i].getIntValue();
+        else if (arg == "--block")      settings.blockSize = juce::jlimit (16, 65536, args[++i].getIntValue());
+        else if (arg == "--threads")    numThreads = juce::jmax (1, args[++i].getIntValue());
+        else if (arg == "--double")     settings.doublePrecision = true;
+        else if (arg == "--tail")       settings.includeTail = true;
+        else if (arg.startsWith ("--")) return fail ("unknown option " + arg);
+        else
+        {
+            const auto file = juce::File::getCurrentWorkingDirectory().getChildFile (arg);
+
+            if (file.isDirectory())
+            {
+                for (const auto& child : file.findChildFiles (juce::File::findFiles, true, audioFileWildcards))
+                    if (! child.getFileNameWithoutExtension().endsWith (settings.suffix))
+                        inputs.add ({ child, child.getParentDirectory().getRelativePathFrom (file) });
+            }
+            else if (file.existsAsFile())
+            {
+                inputs.add ({ file, {} });
+            }
+            else
+            {
+                return fail ("no such file " + arg);
+            }
+        }
+    }
+
+    if (inputs.isEmpty())
+        return fail ("nothing to render");
+
+    // Two inputs can still map to one output, e.g. a.wav and a.wave, or files
+    // of the same name given from different folders; refuse before writing anything
+    {
+        juce::AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+        std::map<juce::File, juce::File> outputs;
+
+        for (const auto& input : inputs)
+        {
+            const auto output = getOutputFile (input, settings, formatManager);
+
+            if (output == juce::File())
+                continue;   // the job reports the unknown format
+
+            const auto [existing, added] = outputs.emplace (output, input.file);
+
+            if (! added)
+                return fail (existing->second.getFullPathName() + " and " + input.file.getFullPathName()
+                              + " would both be written to " + output.getFullPathName());
+        }
+    }
+
+    juce::TimeSliceThread writerThread ("intrusion-render writer");
+    writerThread.startThread();
+
+    Progress progress (inputs.size());
+
+    {
+        juce::ThreadPool pool (juce::jmin (numThreads, inputs.size()));
+
+        for (const auto& input : inputs)
+            pool.addJob (new RenderJob (input, settings, writerThread, progress), true);
+
+        progress.waitUntilFinished();
+    }
+
+    // the pool has finished, so every ThreadedWriter has flushed and closed its file
+    writerThread.stopThread (5000);
+
+    const auto numFailed = progress.getNumFailed();
+
+    if (numFailed > 0)
+        std::cerr << numFailed << " of " << inputs.size() << " files failed" << std::endl;
+
+    return numFailed > 0 ? 1 : 0;
+}
@@ -0,0 +1,153 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    intrusion-shaper-check: checks the CRONCH and ABSOLUTION shapers.
+
+    Each CRONCH accuracy tier is swept against applyCronchToSample, in float
+    and double, and must stay within its error bound.
+
+    ADAA output depends only on the last few inputs, so switching order while
+    running must give exactly what running at the new order all along would,
+    from the first sample after the switch. The switches here land on block
+    boundaries after blocks of different lengths, including single samples.
+
+    Returns non-zero if anything fails, so it can run under CTest.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "IntrusionKernel.h"
+
+namespace
+{
+
+//==============================================================================
+template <typename SampleType>
+struct AntialiasingSwitchCheck
+{
+    /** Runs input through blocks of blockSize, at from for the first
+        switchBlock blocks and at to from then on.
+    */
+    static std::vector<SampleType> run (std::vector<SampleType> data, const CronchAntiderivative& shaper, int blockSize,
+                                        ShaperAntialiasing from, ShaperAntialiasing to, int switchBlock)
+    {
+        CronchADAA::State state;
+
+        for (int start = 0, block = 0; start < (int) data.size(); start += blockSize, ++block)
+        {
+            const auto numSamples = juce::jmin (blockSize, (int) data.size() - start);
+            CronchADAA::process (data.data() + start, numSamples, state, shaper, block < switchBlock ? from : to);
+        }
+
+        return data;
+    }
+
+    static juce::StringArray run()
+    {
+        const auto precision = juce::String (std::is_same_v<SampleType, float> ? "float" : "double");
+        juce::StringArray failures;
+        juce::Random random (0xada);
+
+        std::vector<SampleType> input (4096);
+
+        // Loud enough to cross the shaper's centre and the gate, with some
+        // repeated samples for the ill-conditioned fallbacks
+        for (size_t n = 0; n < input.size(); ++n)
+            input[n] = n % 97 < 3 ? (SampleType) 0.25
+                                  : (SampleType) (0.8 * std::sin (0.031 * (double) n) + 0.1 * (random.nextDouble() - 0.5));
+
+        const CronchAntiderivative shapers[] = { { 20.0, 0.0, false, 0.0 },
+                                                 { 4.0, 0.1, false, 0.0 },
+                                                 { 20.0, 0.0, true, IntrusionKernel<double>::absolutionArgumentThreshold (0.5) } };
+
+        const std::pair<ShaperAntialiasing, ShaperAntialiasing> switches[] =
+        {
+            { ShaperAntialiasing::firstOrderADAA, ShaperAntialiasing::secondOrderADAA },
+            { ShaperAntialiasing::secondOrderADAA, ShaperAntialiasing::firstOrderADAA }
+        };
+
+        for (const auto& shaper : shapers)
+        {
+            for (const auto& [from, to] : switches)
+            {
+                for (auto blockSize : { 1, 2, 3, 64, 65 })
+                {
+                    const auto expected = run (input, shaper, blockSize, to, to, 0);
+
+                    for (auto switchBlock : { 1, 2, 7, 20 })
+                    {
+                        const auto actual = run (input, shaper, blockSize, from, to, switchBlock);
+
+                        for (auto n = (size_t) (switchBlock * blockSize); n < input.size(); ++n)
+                        {
+                            // Bit-identical, not just close
+                            if (std::memcmp (&actual[n], &expected[n], sizeof (SampleType)) != 0)
+                            {
+                                failures.add (precision + ", order " + juce::String ((int) from) + " to " + juce::String ((int) to)
+                                               + " after " + juce::String (switchBlock) + " blocks of " + juce::String (blockSize)
+                                               + ": sample " + juce::String ((int) n) + " is " + juce::String (actual[n], 17)
+                                               + ", expected " + juce::String (expected[n], 17));
+                                break;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        return failures;
+    }
+};
+
+//==============================================================================
+/** The worst error of each tier's vectorised CRONCH over the full amount range,
+    against the bound quoted for it in FastExp.h.
+*/
+template <typename SampleType>
+juce::StringArray checkCronchAccuracy()
+{
+    const auto precision = juce::String (std::is_same_v<SampleType, float> ? "float" : "double");
+    const char* tierNames[] = { "reference", "fast", "table" };
+
+    // A few ulps for the reference, which is the same maths as the scalar code
+    const float bounds[] = { std::is_same_v<SampleType, float> ? 2.5e-7f : 1.0e-12f, 5.0e-6f, 4.0e-6f };
+
+    juce::StringArray failures;
+
+    for (auto accuracy : { CronchAccuracy::reference, CronchAccuracy::fast, CronchAccuracy::table })
+    {
+        const auto report = IntrusionKernel<SampleType>::measureCronchAccuracy (accuracy);
+        const auto bound = bounds[(int) accuracy];
+        const auto description = precision + " CRONCH " + tierNames[(int) accuracy] + " max error "
+                                    + juce::String (report.maxAbsoluteError) + " at x = " + juce::String (report.worstInput)
+                                    + ", amount = " + juce::String (report.worstAmount);
+
+        std::cout << description << std::endl;
+
+        if (! (report.maxAbsoluteError <= bound))
+            failures.add (description + ", over " + juce::String (bound));
+    }
+
+    return failures;
+}
+
+} // namespace
+
+//==============================================================================
+int main()
+{
+    juce::StringArray failures;
+    failures.addArray (checkCronchAccuracy<float>());
+    failures.addArray (checkCronchAccuracy<double>());
+    failures.addArray (AntialiasingSwitchCheck<float>::run());
+    failures.addArray (AntialiasingSwitchCheck<double>::run());
+
+    for (const auto& failure : failures)
+        std::cout << "FAIL: " << failure << std::endl;
+
+    std::cout << (failures.isEmpty() ? "shaper checks passed" : "shaper check failed") << std::endl;
+    return failures.isEmpty() ? 0 : 1;
+}